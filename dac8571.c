@@ -6,12 +6,31 @@
  */
 
 #include "dac8571.h"
+#include "dac8571_log.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+
+// Batch voltage conversion kernel (DAC8571_VoltsToCodes); -DDAC8571_DISABLE_SIMD forces the scalar loop
+#if defined(DAC8571_DISABLE_SIMD)
+  #define DAC8571_VOLTS_KERNEL "scalar"
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+  #define DAC8571_SIMD_SSE2
+  #define DAC8571_VOLTS_KERNEL "SSE2"
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define DAC8571_SIMD_NEON
+  #define DAC8571_VOLTS_KERNEL "NEON"
+#elif defined(__ARM_ARCH_7EM__)
+  #define DAC8571_SIMD_M4
+  #define DAC8571_VOLTS_KERNEL "Cortex-M4"
+#else
+  #define DAC8571_VOLTS_KERNEL "scalar"
+#endif
 
-// Enable or disable debug mode
-#define DEBUG_DAC8571
-
+// Text debug output is opt-in (-DDEBUG_DAC8571); failures are recorded as
+// binary records through dac8571_log.h according to DAC8571_LOG_LEVEL.
 #ifdef DEBUG_DAC8571
   #include <stdio.h>
   #define DEBUG_PRINT(fmt, ...)  \
@@ -24,242 +43,2100 @@
       } while (0)
 #endif
 
+#if defined(HAL_SIM) || defined(HAL_LINUX)
+#include <time.h>
 
-void DAC8571_Init(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address) {
-	const int max_attempts = 5;
-	const uint32_t retry_delay_ms = 25;
+/* Host builds (simulator, Linux i2c-dev): monotonic nanoseconds stand in for the cycle counter */
+static uint32_t DAC8571_CycleCount(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define DAC8571_CYCLE_UNIT "ns"
+#else
+static uint32_t DAC8571_CycleCount(void) {
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+}
+#define DAC8571_CYCLE_UNIT "cycles"
+#endif
 
-	if (!hdac8571 || !hi2c) {
-        DEBUG_PRINT("Error: Invalid handle or I2C pointer in DAC8571_Init\r\n");
-        return;
+#if defined(HAL_SIM) || defined(HAL_LINUX)
+#define DAC8571_CYCLES_PER_US 1000U
+#else
+#define DAC8571_CYCLES_PER_US (SystemCoreClock / 1000000U)
+#endif
+
+static void DAC8571_DelayUs(uint32_t us) {
+    uint32_t start = DAC8571_CycleCount();
+    uint32_t wait = us * DAC8571_CYCLES_PER_US;
+    while ((DAC8571_CycleCount() - start) < wait) {
     }
+}
 
-    if ((address != 0x4C) && (address != 0x4E)){
-    	DEBUG_PRINT("Error: Invalid I2C address in DAC8571_Init\r\n");
-    	return;
+#ifdef DAC8571_ENABLE_STATS
+static void DAC8571_StatsRecord(DAC8571_HandleTypeDef *hdac8571, uint32_t cycles, uint16_t bytes, HAL_StatusTypeDef status) {
+    DAC8571_StatsTypeDef *stats = &hdac8571->stats;
+
+    stats->transactions++;
+    if (status != HAL_OK) {
+        stats->errors++;
+    } else {
+        stats->bytes += bytes;
+    }
+    if (cycles < stats->minCycles || stats->transactions == 1) {
+        stats->minCycles = cycles;
     }
+    if (cycles > stats->maxCycles) {
+        stats->maxCycles = cycles;
+    }
+    stats->totalCycles += cycles;
 
-    hdac8571->hi2c = hi2c;
-    hdac8571->address = (uint16_t)address;
-    hdac8571->lastValue = 0;
-    hdac8571->writeMode = DAC8571_CMD_WRITE_AND_UPDATE_DAC;
-    hdac8571->lastError = DAC8571_OK;
+    // Bucket i holds latencies in [2^i, 2^(i+1))
+    uint8_t bucket = (uint8_t)(31 - __builtin_clz(cycles | 1));
+    stats->histogram[bucket]++;
+}
 
-    if (__HAL_I2C_GET_FLAG(hdac8571->hi2c, I2C_FLAG_BUSY)) {
-        __HAL_I2C_CLEAR_FLAG(hdac8571->hi2c, I2C_FLAG_BUSY);
+  #define DAC8571_STATS_BEGIN()                  uint32_t statsStart = DAC8571_CycleCount()
+  #define DAC8571_STATS_END(hdac, bytes, status) DAC8571_StatsRecord((hdac), DAC8571_CycleCount() - statsStart, (bytes), (status))
+#else
+  #define DAC8571_STATS_BEGIN()                  do { /* nothing */ } while (0)
+  #define DAC8571_STATS_END(hdac, bytes, status) do { /* nothing */ } while (0)
+#endif
+
+/**
+ * @brief Precompute the conversion factors (65535 / reference) for a handle.
+ * @details The integer factor is normalized to use all 32 bits, so the conversion is exact
+ *          except for codes that fall on an exact half-LSB tie.
+ */
+static void DAC8571_SetCodeScale(DAC8571_HandleTypeDef *hdac8571, uint32_t refMicrovolts) {
+    hdac8571->refMicrovolts = refMicrovolts;
+    hdac8571->refVoltage = (float)refMicrovolts / 1000000.0f;
+    hdac8571->codesPerVolt = 65535.0f / hdac8571->refVoltage;
+
+    uint8_t shift = 32;
+    while (shift < 48 && ((uint64_t)65535 << (shift + 1)) / refMicrovolts < 0x100000000ULL) {
+        shift++;
     }
+    hdac8571->codeShift = shift;
+    hdac8571->codeScale = (uint32_t)((((uint64_t)65535 << shift) + refMicrovolts / 2) / refMicrovolts);
+}
 
-    // Try to detect the device multiple times
-    bool connected = false;
-    for (int attempt = 1; attempt <= max_attempts; attempt++) {
-        if (DAC8571_IsConnected(hdac8571) == HAL_OK) {
-            DEBUG_PRINT("DAC8571 connection attempt %d: OK\r\n", attempt);
-            connected = true;
-            break;
+/**
+ * @brief Convert microvolts to a DAC code, rounded to nearest (no division).
+ */
+static inline uint16_t DAC8571_MicrovoltsToCode(const DAC8571_HandleTypeDef *hdac8571, uint32_t microvolts) {
+    uint64_t code = ((uint64_t)microvolts * hdac8571->codeScale + (1ULL << (hdac8571->codeShift - 1))) >> hdac8571->codeShift;
+    return (code > 0xFFFF) ? 0xFFFF : (uint16_t)code;
+}
+
+/**
+ * @brief Apply gain/offset and INL correction to a code, integer only.
+ */
+static inline uint16_t DAC8571_CalApply(const DAC8571_HandleTypeDef *hdac8571, uint16_t code) {
+    int32_t c = (int32_t)(((int64_t)code * hdac8571->calGain + hdac8571->calOffset + 0x8000) >> 16);
+    if (hdac8571->calInlEnabled) {
+        uint32_t k = (c < 0) ? 0 : (c > 0xFFFF) ? 0xFFFF : (uint32_t)c;
+        const int16_t *inl = &hdac8571->calInl[k >> DAC8571_CAL_INL_SHIFT];
+        int32_t frac = (int32_t)(k & ((1u << DAC8571_CAL_INL_SHIFT) - 1));
+        c -= inl[0] + (((inl[1] - inl[0]) * frac) >> DAC8571_CAL_INL_SHIFT);
+    }
+    return (c < 0) ? 0 : (c > 0xFFFF) ? 0xFFFF : (uint16_t)c;
+}
+
+/**
+ * @brief Apply the handle's calibration, if any, to a converted code.
+ */
+static inline uint16_t DAC8571_Calibrated(const DAC8571_HandleTypeDef *hdac8571, uint16_t code) {
+    return hdac8571->calEnabled ? DAC8571_CalApply(hdac8571, code) : code;
+}
+
+/**
+ * @brief Calibrate a block of native-order codes, writing native or wire order; out may alias in.
+ */
+static void DAC8571_CalApplyBlock(const DAC8571_HandleTypeDef *hdac8571, const uint8_t *in, uint8_t *out, uint32_t length, bool wire) {
+    for (uint32_t i = 0; i < length; i++, in += 2, out += 2) {
+        uint16_t code;
+        memcpy(&code, in, sizeof(code));
+        code = DAC8571_CalApply(hdac8571, code);
+        if (wire) {
+            out[0] = (uint8_t)(code >> 8);
+            out[1] = (uint8_t)(code & 0xFF);
         } else {
-            DEBUG_PRINT("DAC8571 connection attempt %d: FAIL\r\n", attempt);
-            HAL_Delay(retry_delay_ms);
+            memcpy(out, &code, sizeof(code));
+        }
+    }
+}
+
+/**
+ * @brief Scale, clamp and round one voltage; the reference the vector kernels must match.
+ * @details The clamps sit between multiply and add so no path can fuse them, and NaN fails both
+ *          compares towards 0.
+ */
+static inline uint16_t DAC8571_VoltToCode(float codesPerVolt, float voltage) {
+    float x = voltage * codesPerVolt;
+    x = (x > 0.0f) ? x : 0.0f;
+    x = (x < 65535.0f) ? x : 65535.0f;
+    return (uint16_t)(x + 0.5f);
+}
+
+/**
+ * @brief Scalar conversion of a block (reference for the self-test and kernel tail).
+ */
+static void DAC8571_VoltsToCodesScalar(float codesPerVolt, const float *volts, uint8_t *out, uint32_t length, bool wire) {
+    for (uint32_t i = 0; i < length; i++, out += 2) {
+        uint16_t code = DAC8571_VoltToCode(codesPerVolt, volts[i]);
+        if (wire) {
+            out[0] = (uint8_t)(code >> 8);
+            out[1] = (uint8_t)(code & 0xFF);
+        } else {
+            memcpy(out, &code, sizeof(code));
+        }
+    }
+}
+
+/**
+ * @brief Convert a block to codes, native or wire byte order; out needs no alignment.
+ */
+static void DAC8571_VoltsToCodesKernel(float codesPerVolt, const float *volts, uint8_t *out, uint32_t length, bool wire) {
+    uint32_t i = 0;
+#if defined(DAC8571_SIMD_SSE2)
+    const __m128 scale = _mm_set1_ps(codesPerVolt);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 full = _mm_set1_ps(65535.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+    for (; i + 8 <= length; i += 8, out += 16) {
+        // maxps/minps return the second operand for NaN, matching the scalar compares
+        __m128 lo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&volts[i]), scale), zero), full);
+        __m128 hi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&volts[i + 4]), scale), zero), full);
+        __m128i lo32 = _mm_cvttps_epi32(_mm_add_ps(lo, half));
+        __m128i hi32 = _mm_cvttps_epi32(_mm_add_ps(hi, half));
+        // SSE2 has only a signed 32->16 pack: shift into its range and back
+        __m128i codes = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo32, bias32), _mm_sub_epi32(hi32, bias32)), bias16);
+        if (wire) {
+            codes = _mm_or_si128(_mm_slli_epi16(codes, 8), _mm_srli_epi16(codes, 8));
+        }
+        _mm_storeu_si128((__m128i *)out, codes);
+    }
+#elif defined(DAC8571_SIMD_NEON)
+    const float32x4_t scale = vdupq_n_f32(codesPerVolt);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t full = vdupq_n_f32(65535.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    for (; i + 8 <= length; i += 8, out += 16) {
+        float32x4_t lo = vmulq_f32(vld1q_f32(&volts[i]), scale);
+        float32x4_t hi = vmulq_f32(vld1q_f32(&volts[i + 4]), scale);
+        // Compare-and-select rather than vmaxq/vminq, which propagate NaN
+        lo = vbslq_f32(vcgtq_f32(lo, zero), lo, zero);
+        hi = vbslq_f32(vcgtq_f32(hi, zero), hi, zero);
+        lo = vbslq_f32(vcltq_f32(lo, full), lo, full);
+        hi = vbslq_f32(vcltq_f32(hi, full), hi, full);
+        uint16x8_t codes = vcombine_u16(vmovn_u32(vcvtq_u32_f32(vaddq_f32(lo, half))),
+                                        vmovn_u32(vcvtq_u32_f32(vaddq_f32(hi, half))));
+        uint8x16_t bytes = vreinterpretq_u8_u16(codes);
+        vst1q_u8(out, wire ? vrev16q_u8(bytes) : bytes);
+    }
+#elif defined(DAC8571_SIMD_M4)
+    // No float SIMD on the M4: two codes per word store, REV16 for wire order
+    for (; i + 2 <= length; i += 2, out += 4) {
+        uint32_t pair = DAC8571_VoltToCode(codesPerVolt, volts[i]) |
+                        ((uint32_t)DAC8571_VoltToCode(codesPerVolt, volts[i + 1]) << 16);
+        if (wire) {
+            pair = __REV16(pair);
+        }
+        memcpy(out, &pair, sizeof(pair));
+    }
+#endif
+    DAC8571_VoltsToCodesScalar(codesPerVolt, &volts[i], out, length - i, wire);
+}
+
+/**
+ * @brief Handle with an asynchronous transfer in flight, per I2C bus.
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    DAC8571_HandleTypeDef *active;
+#ifdef DAC8571_ENABLE_LOCKING
+    volatile uint8_t locked;             ///< Bus lock (atomic test-and-set)
+    DAC8571_LockStatsTypeDef lockStats;  ///< Updated by the lock holder (timeouts atomically)
+#ifdef DAC8571_BUS_LOCK
+    void *mutex;                         ///< RTOS mutex tasks queue on (DAC8571_BUS_MUTEX_NEW)
+    uint8_t mutexHeld;                   ///< The holder of locked also holds the mutex
+#endif
+#endif
+} DAC8571_BusSlotTypeDef;
+
+static DAC8571_BusSlotTypeDef dac8571_busSlots[DAC8571_MAX_BUSES];
+
+static DAC8571_BusSlotTypeDef *DAC8571_FindBusSlot(I2C_HandleTypeDef *hi2c, bool create) {
+    for (uint8_t i = 0; i < DAC8571_MAX_BUSES; i++) {
+        if (dac8571_busSlots[i].hi2c == hi2c) {
+            return &dac8571_busSlots[i];
+        }
+    }
+    if (create) {
+        for (uint8_t i = 0; i < DAC8571_MAX_BUSES; i++) {
+            if (dac8571_busSlots[i].hi2c == NULL) {
+                dac8571_busSlots[i].hi2c = hi2c;
+#if defined(DAC8571_ENABLE_LOCKING) && defined(DAC8571_BUS_LOCK)
+                // NULL (out of RTOS objects) falls back to the flag alone
+                dac8571_busSlots[i].mutex = DAC8571_BUS_MUTEX_NEW();
+#endif
+                return &dac8571_busSlots[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+#ifdef DAC8571_ENABLE_LOCKING
+#if defined(HAL_SIM) || defined(HAL_LINUX)
+  #define DAC8571_IN_ISR() 0
+#else
+  #define DAC8571_IN_ISR() (__get_IPSR() != 0U)
+#endif
+
+#if defined(DAC8571_BUS_LOCK) && (!defined(DAC8571_BUS_UNLOCK) || !defined(DAC8571_BUS_MUTEX_NEW))
+#error "DAC8571_BUS_LOCK needs DAC8571_BUS_UNLOCK and DAC8571_BUS_MUTEX_NEW"
+#endif
+
+/**
+ * @brief Take a bus lock, waiting up to DAC8571_LOCK_TIMEOUT_MS when wait is set.
+ * @details With the DAC8571_BUS_LOCK hooks, tasks first take the bus's RTOS mutex, so a waiting
+ *          task blocks and lends its priority to the holder instead of spinning. The atomic flag is
+ *          then only contended by DMA transfers and interrupt handlers, which finish on their own.
+ *          Interrupt handlers never wait and only try the flag: the holder cannot run until they return.
+ */
+static HAL_StatusTypeDef DAC8571_BusLock(DAC8571_BusSlotTypeDef *slot, bool wait) {
+    if (!slot) {
+        return HAL_ERROR;
+    }
+    bool isr = DAC8571_IN_ISR();
+    if (isr) {
+        wait = false;
+    }
+
+    uint32_t start = DAC8571_CycleCount();
+    uint32_t startTick = HAL_GetTick();
+    bool contended = false;
+#ifdef DAC8571_BUS_LOCK
+    bool mutex = (slot->mutex != NULL && !isr);
+    if (mutex && !DAC8571_BUS_LOCK(slot->mutex, 0)) {
+        if (!wait) {
+            return HAL_BUSY;
+        }
+        contended = true;
+        if (!DAC8571_BUS_LOCK(slot->mutex, DAC8571_LOCK_TIMEOUT_MS)) {
+            __atomic_fetch_add(&slot->lockStats.timeouts, 1, __ATOMIC_RELAXED);
+            return HAL_BUSY;
+        }
+    }
+#endif
+    while (__atomic_test_and_set(&slot->locked, __ATOMIC_ACQUIRE)) {
+        if (!wait || HAL_GetTick() - startTick >= DAC8571_LOCK_TIMEOUT_MS) {
+            if (wait) {
+                __atomic_fetch_add(&slot->lockStats.timeouts, 1, __ATOMIC_RELAXED);
+            }
+#ifdef DAC8571_BUS_LOCK
+            if (mutex) {
+                DAC8571_BUS_UNLOCK(slot->mutex);
+            }
+#endif
+            return HAL_BUSY;
+        }
+        contended = true;
+        DAC8571_LOCK_YIELD();
+    }
+#ifdef DAC8571_BUS_LOCK
+    slot->mutexHeld = mutex;
+#endif
+
+    if (contended) {
+        uint32_t waited = DAC8571_CycleCount() - start;
+        slot->lockStats.contentions++;
+        slot->lockStats.totalWaitCycles += waited;
+        if (waited > slot->lockStats.maxWaitCycles) {
+            slot->lockStats.maxWaitCycles = waited;
+        }
+    }
+    slot->lockStats.acquisitions++;
+    return HAL_OK;
+}
+
+/**
+ * @brief Let the bus be owned by a transfer that completes in an interrupt: the task gives the
+ *        RTOS mutex back before the transfer starts, the flag stays set until the completion handler.
+ */
+static inline void DAC8571_BusHandOff(DAC8571_BusSlotTypeDef *slot) {
+#ifdef DAC8571_BUS_LOCK
+    if (slot->mutexHeld) {
+        slot->mutexHeld = 0;
+        DAC8571_BUS_UNLOCK(slot->mutex);
+    }
+#else
+    (void)slot;
+#endif
+}
+
+static inline void DAC8571_BusUnlock(DAC8571_BusSlotTypeDef *slot) {
+#ifdef DAC8571_BUS_LOCK
+    bool mutexHeld = slot->mutexHeld;
+    slot->mutexHeld = 0;
+    __atomic_clear(&slot->locked, __ATOMIC_RELEASE);
+    if (mutexHeld) {
+        DAC8571_BUS_UNLOCK(slot->mutex);
+    }
+#else
+    __atomic_clear(&slot->locked, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * @brief Lock the handle's bus for one operation; held reports whether this call took the lock
+ *        (a high-speed session already holds it).
+ */
+static HAL_StatusTypeDef DAC8571_Lock(DAC8571_HandleTypeDef *hdac8571, bool *held) {
+    *held = false;
+    if (hdac8571->hsActive) {
+        return HAL_OK;
+    }
+    HAL_StatusTypeDef status = DAC8571_BusLock(DAC8571_FindBusSlot(hdac8571->hi2c, false), true);
+    *held = (status == HAL_OK);
+    return status;
+}
+
+static inline void DAC8571_Unlock(DAC8571_HandleTypeDef *hdac8571, bool held) {
+    if (held) {
+        DAC8571_BusUnlock(DAC8571_FindBusSlot(hdac8571->hi2c, false));
+    }
+}
+#else
+static inline HAL_StatusTypeDef DAC8571_BusLock(DAC8571_BusSlotTypeDef *slot, bool wait) {
+    (void)slot;
+    (void)wait;
+    return HAL_OK;
+}
+
+static inline void DAC8571_BusHandOff(DAC8571_BusSlotTypeDef *slot) {
+    (void)slot;
+}
+
+static inline void DAC8571_BusUnlock(DAC8571_BusSlotTypeDef *slot) {
+    (void)slot;
+}
+
+static inline HAL_StatusTypeDef DAC8571_Lock(DAC8571_HandleTypeDef *hdac8571, bool *held) {
+    (void)hdac8571;
+    *held = false;
+    return HAL_OK;
+}
+
+static inline void DAC8571_Unlock(DAC8571_HandleTypeDef *hdac8571, bool held) {
+    (void)hdac8571;
+    (void)held;
+}
+#endif
+
+/**
+ * @brief Record what the device holds after a successful write.
+ * @details Only plain data writes are cacheable: repeating them cannot change the device state.
+ */
+static inline void DAC8571_CacheStore(DAC8571_HandleTypeDef *hdac8571, uint8_t mode) {
+    hdac8571->cachedMode = mode;
+    hdac8571->cacheValid = (mode == DAC8571_CMD_WRITE_TMP || mode == DAC8571_CMD_WRITE_AND_UPDATE_DAC);
+}
+
+/**
+ * @brief Blocking-transfer timeout derived from the bus clock and transaction length.
+ * @details START + 9 bits per byte (address included) + STOP, times the slack factor, rounded
+ *          up to whole ticks plus one tick so a transfer started just before a tick edge
+ *          is not cut short.
+ */
+static uint32_t DAC8571_TimeoutMs(const DAC8571_HandleTypeDef *hdac8571, uint16_t bytes) {
+    uint32_t bits = 2 + 9 * ((uint32_t)bytes + 1);
+    uint32_t us = (uint32_t)(((uint64_t)bits * 1000000U * hdac8571->timeoutSlack + hdac8571->busClockHz - 1) / hdac8571->busClockHz);
+    uint32_t ms = (us + 999) / 1000 + 1;
+    return (ms < DAC8571_TIMEOUT_MIN_MS) ? DAC8571_TIMEOUT_MIN_MS : ms;
+}
+
+/**
+ * @brief Circuit breaker gate, called before a transfer touches the bus.
+ * @return true if the transfer may proceed; otherwise lastError is DAC8571_BREAKER_ERROR.
+ */
+static bool DAC8571_BreakerAllow(DAC8571_HandleTypeDef *hdac8571) {
+    if (hdac8571->breakerState == DAC8571_BREAKER_CLOSED) {
+        return true;
+    }
+    // Open: after the cooldown let exactly one trial transfer through
+    if (hdac8571->breakerState == DAC8571_BREAKER_OPEN &&
+        (HAL_GetTick() - hdac8571->breakerOpenedTick) >= DAC8571_BREAKER_COOLDOWN_MS) {
+        hdac8571->breakerState = DAC8571_BREAKER_HALF_OPEN;
+        return true;
+    }
+    hdac8571->lastError = DAC8571_BREAKER_ERROR;
+    return false;
+}
+
+/**
+ * @brief Feed a transaction result into the circuit breaker; recover the bus after a timeout.
+ * @details While an asynchronous transfer is still marked busy the caller may be an interrupt,
+ *          so the recovery is only flagged and left to DAC8571_RecoverPending.
+ */
+static HAL_StatusTypeDef DAC8571_RecoverBus(DAC8571_HandleTypeDef *hdac8571);
+
+static void DAC8571_BreakerRecord(DAC8571_HandleTypeDef *hdac8571, HAL_StatusTypeDef status) {
+    if (status == HAL_OK) {
+        hdac8571->consecutiveErrors = 0;
+        hdac8571->breakerState = DAC8571_BREAKER_CLOSED;
+        return;
+    }
+    if (status == HAL_BUSY) {
+        // Bus taken by someone else: says nothing about the device, retry the trial later
+        if (hdac8571->breakerState == DAC8571_BREAKER_HALF_OPEN) {
+            hdac8571->breakerState = DAC8571_BREAKER_OPEN;
+        }
+        return;
+    }
+
+    if (hdac8571->consecutiveErrors < 0xFF) {
+        hdac8571->consecutiveErrors++;
+    }
+    if (hdac8571->breakerState == DAC8571_BREAKER_HALF_OPEN ||
+        (hdac8571->breakerState == DAC8571_BREAKER_CLOSED && hdac8571->consecutiveErrors >= DAC8571_BREAKER_THRESHOLD)) {
+        if (hdac8571->breakerState == DAC8571_BREAKER_CLOSED) {
+            hdac8571->breakerTrips++;
+            DAC8571_LOG_WARN(DAC8571_EVT_BREAKER_OPEN, hdac8571->address, hdac8571->consecutiveErrors, status);
+        }
+        hdac8571->breakerState = DAC8571_BREAKER_OPEN;
+        hdac8571->breakerOpenedTick = HAL_GetTick();
+    }
+
+    if (status == HAL_TIMEOUT && hdac8571->sclPort) {
+        if (hdac8571->busy) {
+            hdac8571->recoveryPending = 1;
+        } else {
+            DAC8571_RecoverBus(hdac8571);
+        }
+    }
+}
+
+/**
+ * @brief Run a bus recovery deferred from interrupt context (caller holds the bus lock).
+ */
+static void DAC8571_RecoverPending(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571->recoveryPending || hdac8571->busy || hdac8571->hsActive) {
+        return;
+    }
+    DAC8571_BusSlotTypeDef *slot = DAC8571_FindBusSlot(hdac8571->hi2c, false);
+    if (slot && slot->active) {
+        // Another device's transfer is on the bus: try again on the next call
+        return;
+    }
+    DAC8571_RecoverBus(hdac8571);
+}
+
+/*
+ * Sequential-frame option that forces a repeated START with a new address byte. The F4 HAL only
+ * restarts on I2C_NEXT_FRAME when the direction changes; I2C_OTHER_FRAME restarts unconditionally.
+ */
+#ifdef I2C_OTHER_FRAME
+#define DAC8571_SEQ_RESTART I2C_OTHER_FRAME
+#else
+#define DAC8571_SEQ_RESTART I2C_NEXT_FRAME
+#endif
+
+/**
+ * @brief Wait for an interrupt-driven transfer to finish.
+ */
+static HAL_StatusTypeDef DAC8571_WaitReady(I2C_HandleTypeDef *hi2c, uint32_t timeoutMs) {
+    uint32_t start = HAL_GetTick();
+    while (HAL_I2C_GetState(hi2c) != HAL_I2C_STATE_READY) {
+        if ((HAL_GetTick() - start) > timeoutMs) {
+            return HAL_TIMEOUT;
+        }
+    }
+    return (HAL_I2C_GetError(hi2c) == HAL_I2C_ERROR_NONE) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef DAC8571_Hal_Transmit(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs) {
+    return HAL_I2C_Master_Transmit(hdac8571->hi2c, devAddress, data, size, timeoutMs);
+}
+
+HAL_StatusTypeDef DAC8571_Hal_Receive(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs) {
+    return HAL_I2C_Master_Receive(hdac8571->hi2c, devAddress, data, size, timeoutMs);
+}
+
+HAL_StatusTypeDef DAC8571_Hal_Probe(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint32_t timeoutMs) {
+    return HAL_I2C_IsDeviceReady(hdac8571->hi2c, devAddress, 1, timeoutMs);
+}
+
+HAL_StatusTypeDef DAC8571_Hal_SeqTransmit(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t options, uint32_t timeoutMs) {
+    HAL_StatusTypeDef status = HAL_I2C_Master_Seq_Transmit_IT(hdac8571->hi2c, devAddress, data, size, options);
+    if (status != HAL_OK) {
+        return status;
+    }
+    return DAC8571_WaitReady(hdac8571->hi2c, timeoutMs);
+}
+
+HAL_StatusTypeDef DAC8571_Hal_SeqStop(DAC8571_HandleTypeDef *hdac8571, uint32_t timeoutMs) {
+    I2C_HandleTypeDef *hi2c = hdac8571->hi2c;
+    if (HAL_I2C_GetState(hi2c) != HAL_I2C_STATE_READY) {
+        // Frame still in flight (it timed out): the HAL stops it
+        HAL_StatusTypeDef status = HAL_I2C_Master_Abort_IT(hi2c, hdac8571->address << 1);
+        if (status != HAL_OK) {
+            return status;
+        }
+        return DAC8571_WaitReady(hi2c, timeoutMs);
+    }
+
+    // A finished frame without STOP leaves the HAL idle (Abort_IT refuses) and SCL held low
+    SET_BIT(hi2c->Instance->CR1, I2C_CR1_STOP);
+    uint32_t start = HAL_GetTick();
+    while (__HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_BUSY)) {
+        if ((HAL_GetTick() - start) > timeoutMs) {
+            return HAL_TIMEOUT;
+        }
+    }
+    return (HAL_I2C_GetError(hi2c) == HAL_I2C_ERROR_NONE) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef DAC8571_Hal_TransmitAsync(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size) {
+    return HAL_I2C_Master_Transmit_DMA(hdac8571->hi2c, devAddress, data, size);
+}
+
+const DAC8571_TransportTypeDef DAC8571_HalTransport = {
+    DAC8571_Hal_Transmit,
+    DAC8571_Hal_Receive,
+    DAC8571_Hal_Probe,
+    DAC8571_Hal_SeqTransmit,
+    DAC8571_Hal_SeqStop,
+    DAC8571_Hal_TransmitAsync
+};
+
+// Transport call: direct when bound at compile time, through the handle's table otherwise
+#ifdef DAC8571_STATIC_TRANSPORT
+  #define DAC8571_BUS(hdac, op)     DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, op)
+  #define DAC8571_BUS_HAS(hdac, op) 1
+  #define DAC8571_BUS_IS_HAL(hdac)  (DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, Transmit) == DAC8571_Hal_Transmit)
+#else
+  #define DAC8571_BUS(hdac, op)     ((hdac)->transport->op)
+  #define DAC8571_BUS_HAS(hdac, op) ((hdac)->transport->op != NULL)
+  #define DAC8571_BUS_IS_HAL(hdac)  ((hdac)->transport == &DAC8571_HalTransport)
+#endif
+
+/**
+ * @brief Blocking sequential frame (START or repeated START, STOP only for last-frame options).
+ */
+static HAL_StatusTypeDef DAC8571_SeqTransmit(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *buffer, uint16_t size, uint32_t options) {
+    return DAC8571_BUS(hdac8571, SeqTransmit)(hdac8571, devAddress, buffer, size, options, DAC8571_TimeoutMs(hdac8571, size));
+}
+
+/**
+ * @brief Send the STOP that ends a held bus (sequential transfers).
+ */
+static HAL_StatusTypeDef DAC8571_SendStop(DAC8571_HandleTypeDef *hdac8571) {
+    return DAC8571_BUS(hdac8571, SeqStop)(hdac8571, DAC8571_TIMEOUT_MIN_MS);
+}
+
+/**
+ * @brief Leave high-speed mode: optionally send STOP, then restore the F/S clock.
+ */
+static void DAC8571_HSExit(DAC8571_HandleTypeDef *hdac8571, bool sendStop) {
+    if (sendStop) {
+        DAC8571_SendStop(hdac8571);
+    }
+    hdac8571->hi2c->Init.ClockSpeed = hdac8571->hsSavedClockHz;
+    HAL_I2C_Init(hdac8571->hi2c);
+    hdac8571->busClockHz = hdac8571->hsSavedClockHz ? hdac8571->hsSavedClockHz : 100000U;
+    hdac8571->hsActive = 0;
+    DAC8571_Unlock(hdac8571, hdac8571->hsLockHeld);
+    hdac8571->hsLockHeld = 0;
+}
+
+static HAL_StatusTypeDef DAC8571_Transmit(DAC8571_HandleTypeDef *hdac8571, uint8_t *buffer, uint16_t size) {
+    if (hdac8571->busy) {
+        return HAL_BUSY;
+    }
+    DAC8571_RecoverPending(hdac8571);
+
+    HAL_StatusTypeDef status;
+    DAC8571_STATS_BEGIN();
+    if (hdac8571->hsActive) {
+        // High-speed session: repeated START keeps the bus in HS mode
+        status = DAC8571_SeqTransmit(hdac8571, hdac8571->address << 1, buffer, size, DAC8571_SEQ_RESTART);
+    } else {
+        status = DAC8571_BUS(hdac8571, Transmit)(hdac8571, hdac8571->address << 1, buffer, size, DAC8571_TimeoutMs(hdac8571, size));
+    }
+    DAC8571_STATS_END(hdac8571, size, status);
+    if (status != HAL_OK && hdac8571->hsActive) {
+        // A NACK ends the sequence with a STOP; a timeout leaves the bus to us
+        DAC8571_HSExit(hdac8571, status == HAL_TIMEOUT);
+    }
+    DAC8571_BreakerRecord(hdac8571, status);
+    return status;
+}
+
+static HAL_StatusTypeDef DAC8571_TransmitAsync(DAC8571_HandleTypeDef *hdac8571, uint8_t *buffer, uint16_t size, uint16_t lastSample) {
+    if (hdac8571->hsActive || !DAC8571_BUS_HAS(hdac8571, TransmitAsync)) {
+        DEBUG_PRINT("Error: Asynchronous transfers are not available (high-speed session or transport)\r\n");
+        return HAL_ERROR;
+    }
+    DAC8571_BusSlotTypeDef *slot = DAC8571_FindBusSlot(hdac8571->hi2c, true);
+    if (!slot) {
+        DEBUG_PRINT("Error: No free bus slot for asynchronous transfer (DAC8571_MAX_BUSES)\r\n");
+        return HAL_ERROR;
+    }
+    // Never waits: another task's blocking transfer on this bus is reported as HAL_BUSY
+    if (slot->active || DAC8571_BusLock(slot, false) != HAL_OK) {
+        return HAL_BUSY;
+    }
+
+    hdac8571->busy = 1;
+    hdac8571->cacheValid = 0;
+    hdac8571->pendingValue = lastSample;
+    hdac8571->pendingSize = size;
+    hdac8571->pendingMode = buffer[0];
+#ifdef DAC8571_ENABLE_STATS
+    hdac8571->asyncStart = DAC8571_CycleCount();
+#endif
+    slot->active = hdac8571;
+    // The completion interrupt releases the bus, so the task's mutex goes back now
+    DAC8571_BusHandOff(slot);
+
+    HAL_StatusTypeDef status = DAC8571_BUS(hdac8571, TransmitAsync)(hdac8571, hdac8571->address << 1, buffer, size);
+    if (status != HAL_OK) {
+#ifdef DAC8571_ENABLE_STATS
+        DAC8571_StatsRecord(hdac8571, DAC8571_CycleCount() - hdac8571->asyncStart, size, status);
+#endif
+        slot->active = NULL;
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DAC8571_BreakerRecord(hdac8571, status);
+        hdac8571->busy = 0;
+        DAC8571_BusUnlock(slot);
+        DAC8571_LOG_ERROR(DAC8571_EVT_DMA_START_FAIL, hdac8571->address, lastSample, status);
+        DEBUG_PRINT("Error: Failed to start DMA write to DAC8571 at address 0x%02X. ERROR = %s \r\n", hdac8571->address, HAL_StatusToString(status));
+    }
+    return status;
+}
+
+void DAC8571_Init(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address) {
+    DAC8571_InitWithReference(hdac8571, hi2c, address, (float)DAC8571_REF_VOLTAGE);
+}
+
+/**
+ * @brief Validate parameters and reset the handle state (shared by blocking and non-blocking init).
+ */
+static HAL_StatusTypeDef DAC8571_SetupHandle(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address, float refVoltage) {
+	if (!hdac8571 || !hi2c) {
+        DEBUG_PRINT("Error: Invalid handle or I2C pointer in DAC8571_Init\r\n");
+        return HAL_ERROR;
+    }
+
+    if ((address != 0x4C) && (address != 0x4E)){
+    	DEBUG_PRINT("Error: Invalid I2C address in DAC8571_Init\r\n");
+    	return HAL_ERROR;
+    }
+
+    if (refVoltage < DAC8571_REF_VOLTAGE_MIN || refVoltage > DAC8571_REF_VOLTAGE_MAX) {
+        DEBUG_PRINT("Error: Invalid reference voltage in DAC8571_Init\r\n");
+        return HAL_ERROR;
+    }
+
+#ifdef DAC8571_ENABLE_LOCKING
+    // Bus slots are created here, before any task shares the bus
+    if (!DAC8571_FindBusSlot(hi2c, true)) {
+        DEBUG_PRINT("Error: No free bus slot for the bus lock (DAC8571_MAX_BUSES)\r\n");
+        return HAL_ERROR;
+    }
+#endif
+
+    hdac8571->hi2c = hi2c;
+    if (hdac8571->transport == NULL) {
+        hdac8571->transport = &DAC8571_HalTransport;
+    }
+    hdac8571->address = (uint16_t)address;
+    hdac8571->lastValue = 0;
+    hdac8571->cacheEnabled = 0;
+    hdac8571->cacheValid = 0;
+    hdac8571->cachedMode = 0;
+    hdac8571->suppressedWrites = 0;
+    hdac8571->writeMode = DAC8571_CMD_WRITE_AND_UPDATE_DAC;
+    hdac8571->lastError = DAC8571_OK;
+    DAC8571_SetCodeScale(hdac8571, (uint32_t)(refVoltage * 1000000.0f + 0.5f));
+    DAC8571_ClearCalibration(hdac8571);
+    hdac8571->busClockHz = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+    hdac8571->timeoutSlack = DAC8571_TIMEOUT_SLACK;
+    hdac8571->hsActive = 0;
+    hdac8571->hsLockHeld = 0;
+    hdac8571->busy = 0;
+    hdac8571->pendingValue = 0;
+    hdac8571->pendingSize = 0;
+#ifdef DAC8571_ENABLE_STATS
+    DAC8571_ResetStats(hdac8571);
+#endif
+    hdac8571->TxCpltCallback = NULL;
+    hdac8571->ErrorCallback = NULL;
+    hdac8571->initState = DAC8571_INIT_IDLE;
+    hdac8571->initAttempts = 0;
+    hdac8571->initNextTick = 0;
+    hdac8571->breakerState = DAC8571_BREAKER_CLOSED;
+    hdac8571->consecutiveErrors = 0;
+    hdac8571->breakerTrips = 0;
+    hdac8571->busRecoveries = 0;
+    hdac8571->recoveryPending = 0;
+
+    if (DAC8571_BUS_IS_HAL(hdac8571) && __HAL_I2C_GET_FLAG(hdac8571->hi2c, I2C_FLAG_BUSY)) {
+        __HAL_I2C_CLEAR_FLAG(hdac8571->hi2c, I2C_FLAG_BUSY);
+    }
+    return HAL_OK;
+}
+
+/**
+ * @brief Address the device and check for an ACK (caller holds the bus lock).
+ */
+static HAL_StatusTypeDef DAC8571_Probe(DAC8571_HandleTypeDef *hdac8571) {
+	DAC8571_RecoverPending(hdac8571);
+	DAC8571_STATS_BEGIN();
+	HAL_StatusTypeDef status = DAC8571_BUS(hdac8571, Probe)(
+		hdac8571,
+		hdac8571->address << 1,
+		DAC8571_TimeoutMs(hdac8571, 0)
+	);
+	DAC8571_STATS_END(hdac8571, 0, status);
+	DAC8571_BreakerRecord(hdac8571, status);
+
+	if (status != HAL_OK) {
+		hdac8571->lastError = DAC8571_I2C_ERROR;
+		DEBUG_PRINT("Error: DAC8571 not responding at address 0x%02X\r\n", hdac8571->address);
+	}
+	return status;
+}
+
+void DAC8571_InitWithReference(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address, float refVoltage) {
+	const int max_attempts = DAC8571_INIT_ATTEMPTS;
+	const uint32_t retry_delay_ms = DAC8571_INIT_RETRY_MS;
+
+    if (DAC8571_SetupHandle(hdac8571, hi2c, address, refVoltage) != HAL_OK) {
+        return;
+    }
+#ifdef DAC8571_ENABLE_STATS
+    uint32_t initStart = DAC8571_CycleCount();
+#endif
+
+    // Try to detect the device multiple times
+    bool connected = false;
+    for (int attempt = 1; attempt <= max_attempts; attempt++) {
+        if (DAC8571_IsConnected(hdac8571) == HAL_OK) {
+            DEBUG_PRINT("DAC8571 connection attempt %d: OK\r\n", attempt);
+            connected = true;
+            break;
+        } else {
+            DAC8571_LOG_WARN(DAC8571_EVT_PROBE_FAIL, address, attempt, HAL_ERROR);
+            DEBUG_PRINT("DAC8571 connection attempt %d: FAIL\r\n", attempt);
+            HAL_Delay(retry_delay_ms);
+        }
+    }
+
+#ifdef DAC8571_ENABLE_STATS
+    hdac8571->stats.initCycles = DAC8571_CycleCount() - initStart;
+#endif
+
+    if (!connected) {
+        DAC8571_LOG_ERROR(DAC8571_EVT_INIT_FAIL, address, max_attempts, HAL_ERROR);
+        DEBUG_PRINT("Error: DAC8571 not responding after %d attempts!\r\n", max_attempts);
+        //hdac8571->lastError = DAC8571_ERROR_NOT_CONNECTED;
+        hdac8571->initState = DAC8571_INIT_ABSENT;
+        return;
+    }
+
+    hdac8571->initState = DAC8571_INIT_READY;
+    DAC8571_LOG_INFO(DAC8571_EVT_INIT_OK, address, 0, HAL_OK);
+    DEBUG_PRINT("DAC8571_Init successful\r\n");
+}
+
+HAL_StatusTypeDef DAC8571_InitAsync(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address) {
+    HAL_StatusTypeDef status = DAC8571_SetupHandle(hdac8571, hi2c, address, (float)DAC8571_REF_VOLTAGE);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    hdac8571->initState = DAC8571_INIT_PROBING;
+    hdac8571->initNextTick = HAL_GetTick();
+    return HAL_OK;
+}
+
+uint8_t DAC8571_InitPoll(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_InitPoll\r\n");
+        return DAC8571_INIT_IDLE;
+    }
+    if (hdac8571->initState != DAC8571_INIT_PROBING) {
+        return hdac8571->initState;
+    }
+
+    // Not due yet, or another device is using the bus: try again on a later poll
+    if ((int32_t)(HAL_GetTick() - hdac8571->initNextTick) < 0 ||
+        (DAC8571_BUS_IS_HAL(hdac8571) && HAL_I2C_GetState(hdac8571->hi2c) != HAL_I2C_STATE_READY)) {
+        return DAC8571_INIT_PROBING;
+    }
+
+    DAC8571_BusSlotTypeDef *slot = DAC8571_FindBusSlot(hdac8571->hi2c, false);
+    if (DAC8571_BusLock(slot, false) != HAL_OK) {
+        return DAC8571_INIT_PROBING;
+    }
+    hdac8571->initAttempts++;
+    HAL_StatusTypeDef status = DAC8571_Probe(hdac8571);
+    DAC8571_BusUnlock(slot);
+    if (status == HAL_OK) {
+        hdac8571->initState = DAC8571_INIT_READY;
+        hdac8571->lastError = DAC8571_OK;
+        DAC8571_LOG_INFO(DAC8571_EVT_INIT_OK, hdac8571->address, hdac8571->initAttempts, HAL_OK);
+        return DAC8571_INIT_READY;
+    }
+
+    DAC8571_LOG_WARN(DAC8571_EVT_PROBE_FAIL, hdac8571->address, hdac8571->initAttempts, HAL_ERROR);
+    if (hdac8571->initAttempts >= DAC8571_INIT_ATTEMPTS) {
+        hdac8571->initState = DAC8571_INIT_ABSENT;
+        DAC8571_LOG_ERROR(DAC8571_EVT_INIT_FAIL, hdac8571->address, hdac8571->initAttempts, HAL_ERROR);
+        return DAC8571_INIT_ABSENT;
+    }
+
+    hdac8571->initNextTick = HAL_GetTick() + DAC8571_INIT_RETRY_MS;
+    return DAC8571_INIT_PROBING;
+}
+
+uint8_t DAC8571_InitPollAll(DAC8571_HandleTypeDef **handles, uint8_t count) {
+    uint8_t pending = 0;
+    if (!handles) {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (handles[i] && DAC8571_InitPoll(handles[i]) == DAC8571_INIT_PROBING) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+uint8_t DAC8571_GetInitState(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetInitState\r\n");
+        return DAC8571_INIT_IDLE;
+    }
+    return hdac8571->initState;
+}
+
+HAL_StatusTypeDef DAC8571_SetTransport(DAC8571_HandleTypeDef *hdac8571, const DAC8571_TransportTypeDef *transport, void *context) {
+    if (hdac8571 == NULL) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_SetTransport\r\n");
+        return HAL_ERROR;
+    }
+    if (transport != NULL && (transport->Transmit == NULL || transport->Receive == NULL || transport->Probe == NULL ||
+                              transport->SeqTransmit == NULL || transport->SeqStop == NULL)) {
+        DEBUG_PRINT("Error: Incomplete transport in DAC8571_SetTransport\r\n");
+        return HAL_ERROR;
+    }
+    hdac8571->transport = (transport != NULL) ? transport : &DAC8571_HalTransport;
+    hdac8571->transportContext = context;
+    return HAL_OK;
+}
+
+/**
+ * @brief Write a value with the given control byte (caller holds the bus lock).
+ */
+static HAL_StatusTypeDef DAC8571_WriteValue(DAC8571_HandleTypeDef *hdac8571, uint8_t mode, uint16_t value) {
+    // Write-through cache: the device already holds this value with this control byte
+    if (hdac8571->cacheEnabled && hdac8571->cacheValid &&
+        value == hdac8571->lastValue && mode == hdac8571->cachedMode) {
+        hdac8571->suppressedWrites++;
+        hdac8571->lastError = DAC8571_OK;
+        return HAL_OK;
+    }
+    if (!DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    uint8_t buffer[3] = {mode, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    //DEBUG_PRINT("Data on input: 0x%04X \r\n", value);
+    //DEBUG_PRINT("Data to send:  0x%02X 0x%02X 0x%02X\r\n", buffer[0], buffer[1], buffer[2]);
+
+    HAL_StatusTypeDef status = DAC8571_Transmit(hdac8571, buffer, sizeof(buffer));
+    if (status != HAL_OK) {
+        hdac8571->cacheValid = 0;
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_WRITE_FAIL, hdac8571->address, value, status);
+        DEBUG_PRINT("Error: Failed to write value 0x%04X to DAC8571 at address 0x%02X. ERROR = %s \r\n", value, hdac8571->address, HAL_StatusToString(status));
+        return status;
+    }
+
+    hdac8571->lastValue = value;
+    DAC8571_CacheStore(hdac8571, buffer[0]);
+    hdac8571->lastError = DAC8571_OK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Write(DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_Write\r\n");
+        return HAL_ERROR;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status == HAL_OK) {
+        status = DAC8571_WriteValue(hdac8571, hdac8571->writeMode, value);
+        DAC8571_Unlock(hdac8571, held);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_IsConnected(DAC8571_HandleTypeDef *hdac8571) {
+//    if (!hdac8571) {
+//        DEBUG_PRINT("Error: Invalid handle in DAC8571_IsConnected\r\n");
+//        return HAL_ERROR;
+//    }
+//
+//    HAL_StatusTypeDef status = DAC8571_Read(hdac8571);
+//    if (status != HAL_OK) {
+//        hdac8571->lastError = DAC8571_I2C_ERROR;
+//        DEBUG_PRINT("Error: DAC8571 not responding at address 0x%02X\r\n", hdac8571->address);
+//    }
+	if (!hdac8571) {
+		DEBUG_PRINT("Error: Invalid handle in DAC8571_IsConnected\r\n");
+		return HAL_ERROR;
+	}
+
+	bool held;
+	HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+	if (status == HAL_OK) {
+		status = DAC8571_Probe(hdac8571);
+		DAC8571_Unlock(hdac8571, held);
+	}
+
+	//printf("DAC8571_IsConnected returned: %s (0x%02X)\r\n", HAL_StatusToString(status), (uint8_t)status);
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_WriteArray(DAC8571_HandleTypeDef *hdac8571, uint16_t *arr, uint8_t length) {
+    if (!hdac8571 || !arr || length == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_WriteArray\r\n");
+        return HAL_ERROR;
+    }
+
+    if (length > 14) {
+        hdac8571->lastError = DAC8571_BUFFER_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_BUFFER_OVERFLOW, hdac8571->address, length, HAL_ERROR);
+        DEBUG_PRINT("Error: Buffer overflow in DAC8571_WriteArray\r\n");
+        return HAL_ERROR;
+    }
+
+    HAL_StatusTypeDef status = HAL_OK;
+    for (uint8_t i = 0; i < length; i++) {
+        status = DAC8571_Write(hdac8571, arr[i]);
+        if (status != HAL_OK) {
+            return status;
+        }
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_WriteStream(DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length) {
+    if (!hdac8571 || !arr || length == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_WriteStream\r\n");
+        return HAL_ERROR;
+    }
+    if (!DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    uint8_t buffer[1 + 2 * DAC8571_STREAM_MAX_SAMPLES];
+    buffer[0] = hdac8571->writeMode;
+
+    uint16_t sent = 0;
+    while (sent < length) {
+        uint16_t count = length - sent;
+        if (count > DAC8571_STREAM_MAX_SAMPLES) {
+            count = DAC8571_STREAM_MAX_SAMPLES;
+        }
+
+        // Control byte once, then MSB/LSB pairs back to back
+        uint8_t *p = &buffer[1];
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t value = arr[sent + i];
+            *p++ = (uint8_t)(value >> 8);
+            *p++ = (uint8_t)(value & 0xFF);
+        }
+
+        status = DAC8571_Transmit(hdac8571, buffer, (uint16_t)(1 + 2 * count));
+        if (status != HAL_OK) {
+            hdac8571->cacheValid = 0;
+            hdac8571->lastError = DAC8571_I2C_ERROR;
+            DAC8571_LOG_ERROR(DAC8571_EVT_STREAM_FAIL, hdac8571->address, count, status);
+            DEBUG_PRINT("Error: Stream write of %u samples to DAC8571 at address 0x%02X failed. ERROR = %s \r\n", count, hdac8571->address, HAL_StatusToString(status));
+            break;
+        }
+
+        sent += count;
+        hdac8571->lastValue = arr[sent - 1];
+        DAC8571_CacheStore(hdac8571, buffer[0]);
+    }
+
+    if (status == HAL_OK) {
+        hdac8571->lastError = DAC8571_OK;
+    }
+    DAC8571_Unlock(hdac8571, held);
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_WriteAsync(DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_WriteAsync\r\n");
+        return HAL_ERROR;
+    }
+    if (hdac8571->busy || !DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    hdac8571->txBuffer[0] = hdac8571->writeMode;
+    hdac8571->txBuffer[1] = (uint8_t)(value >> 8);
+    hdac8571->txBuffer[2] = (uint8_t)(value & 0xFF);
+    return DAC8571_TransmitAsync(hdac8571, hdac8571->txBuffer, 3, value);
+}
+
+HAL_StatusTypeDef DAC8571_WriteArrayAsync(DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length) {
+    if (!hdac8571 || !arr || length == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_WriteArrayAsync\r\n");
+        return HAL_ERROR;
+    }
+
+    if (length > DAC8571_ASYNC_MAX_SAMPLES) {
+        hdac8571->lastError = DAC8571_BUFFER_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_BUFFER_OVERFLOW, hdac8571->address, length, HAL_ERROR);
+        DEBUG_PRINT("Error: Buffer overflow in DAC8571_WriteArrayAsync\r\n");
+        return HAL_ERROR;
+    }
+    if (hdac8571->busy || !DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    uint8_t *p = hdac8571->txBuffer;
+    *p++ = hdac8571->writeMode;
+    for (uint16_t i = 0; i < length; i++) {
+        *p++ = (uint8_t)(arr[i] >> 8);
+        *p++ = (uint8_t)(arr[i] & 0xFF);
+    }
+    return DAC8571_TransmitAsync(hdac8571, hdac8571->txBuffer, (uint16_t)(1 + 2 * length), arr[length - 1]);
+}
+
+HAL_StatusTypeDef DAC8571_EncodeFrames(DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length, uint8_t *frame, uint32_t frameSize) {
+    if (!hdac8571 || !arr || !frame || length == 0 || length > DAC8571_FRAME_MAX_SAMPLES) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_EncodeFrames\r\n");
+        return HAL_ERROR;
+    }
+    if (frameSize < DAC8571_FRAME_SIZE(length)) {
+        hdac8571->lastError = DAC8571_BUFFER_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_BUFFER_OVERFLOW, hdac8571->address, length, HAL_ERROR);
+        DEBUG_PRINT("Error: Buffer overflow in DAC8571_EncodeFrames\r\n");
+        return HAL_ERROR;
+    }
+
+    uint8_t *p = frame;
+    *p++ = hdac8571->writeMode;
+    for (uint16_t i = 0; i < length; i++) {
+        *p++ = (uint8_t)(arr[i] >> 8);
+        *p++ = (uint8_t)(arr[i] & 0xFF);
+    }
+    return HAL_OK;
+}
+
+/**
+ * @brief Check that size describes a whole frame buffer: control byte plus at least one sample.
+ */
+static inline bool DAC8571_FrameSizeValid(uint16_t size) {
+    return size >= DAC8571_FRAME_SIZE(1) && (size & 1U) == 1U;
+}
+
+HAL_StatusTypeDef DAC8571_WriteFrames(DAC8571_HandleTypeDef *hdac8571, const uint8_t *frame, uint16_t size) {
+    if (!hdac8571 || !frame || !DAC8571_FrameSizeValid(size)) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_WriteFrames\r\n");
+        return HAL_ERROR;
+    }
+    if (!DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // The transport only reads the buffer
+    status = DAC8571_Transmit(hdac8571, (uint8_t *)frame, size);
+    if (status != HAL_OK) {
+        hdac8571->cacheValid = 0;
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_STREAM_FAIL, hdac8571->address, (uint16_t)(size / 2), status);
+        DEBUG_PRINT("Error: Frame write of %u bytes to DAC8571 at address 0x%02X failed. ERROR = %s \r\n", size, hdac8571->address, HAL_StatusToString(status));
+    } else {
+        hdac8571->lastValue = (uint16_t)((frame[size - 2] << 8) | frame[size - 1]);
+        DAC8571_CacheStore(hdac8571, frame[0]);
+        hdac8571->lastError = DAC8571_OK;
+    }
+    DAC8571_Unlock(hdac8571, held);
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_WriteFramesAsync(DAC8571_HandleTypeDef *hdac8571, const uint8_t *frame, uint16_t size) {
+    if (!hdac8571 || !frame || !DAC8571_FrameSizeValid(size)) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_WriteFramesAsync\r\n");
+        return HAL_ERROR;
+    }
+    if (hdac8571->busy || !DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+    return DAC8571_TransmitAsync(hdac8571, (uint8_t *)frame, size, (uint16_t)((frame[size - 2] << 8) | frame[size - 1]));
+}
+
+uint8_t DAC8571_IsBusy(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_IsBusy\r\n");
+        return 0;
+    }
+    return hdac8571->busy;
+}
+
+HAL_StatusTypeDef DAC8571_RegisterCallbacks(DAC8571_HandleTypeDef *hdac8571, DAC8571_CallbackTypeDef txCplt, DAC8571_CallbackTypeDef error) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_RegisterCallbacks\r\n");
+        return HAL_ERROR;
+    }
+    hdac8571->TxCpltCallback = txCplt;
+    hdac8571->ErrorCallback = error;
+    return HAL_OK;
+}
+
+void DAC8571_I2C_MasterTxCpltHandler(I2C_HandleTypeDef *hi2c) {
+    DAC8571_BusSlotTypeDef *slot = DAC8571_FindBusSlot(hi2c, false);
+    if (!slot || !slot->active) {
+        return;
+    }
+
+    DAC8571_HandleTypeDef *hdac8571 = slot->active;
+    slot->active = NULL;
+#ifdef DAC8571_ENABLE_STATS
+    DAC8571_StatsRecord(hdac8571, DAC8571_CycleCount() - hdac8571->asyncStart, hdac8571->pendingSize, HAL_OK);
+#endif
+    hdac8571->lastValue = hdac8571->pendingValue;
+    DAC8571_CacheStore(hdac8571, hdac8571->pendingMode);
+    hdac8571->lastError = DAC8571_OK;
+    hdac8571->busy = 0;
+    DAC8571_BreakerRecord(hdac8571, HAL_OK);
+    DAC8571_BusUnlock(slot);
+
+    if (hdac8571->TxCpltCallback) {
+        hdac8571->TxCpltCallback(hdac8571);
+    }
+}
+
+void DAC8571_I2C_ErrorHandler(I2C_HandleTypeDef *hi2c) {
+    DAC8571_BusSlotTypeDef *slot = DAC8571_FindBusSlot(hi2c, false);
+    if (!slot || !slot->active) {
+        return;
+    }
+
+    DAC8571_HandleTypeDef *hdac8571 = slot->active;
+    slot->active = NULL;
+#ifdef DAC8571_ENABLE_STATS
+    DAC8571_StatsRecord(hdac8571, DAC8571_CycleCount() - hdac8571->asyncStart, hdac8571->pendingSize, HAL_ERROR);
+#endif
+    hdac8571->lastError = DAC8571_I2C_ERROR;
+    // Recorded while still busy: a timeout only flags the bus for recovery outside the interrupt
+    DAC8571_BreakerRecord(hdac8571, (HAL_I2C_GetError(hi2c) & HAL_I2C_ERROR_TIMEOUT) ? HAL_TIMEOUT : HAL_ERROR);
+    hdac8571->busy = 0;
+    DAC8571_BusUnlock(slot);
+    DAC8571_LOG_ERROR(DAC8571_EVT_DMA_ERROR, hdac8571->address, hdac8571->pendingValue, HAL_ERROR);
+
+    if (hdac8571->ErrorCallback) {
+        hdac8571->ErrorCallback(hdac8571);
+    }
+}
+
+#ifdef DAC8571_USE_HAL_I2C_CALLBACKS
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    DAC8571_I2C_MasterTxCpltHandler(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    DAC8571_I2C_ErrorHandler(hi2c);
+}
+#endif
+
+uint16_t DAC8571_Read(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_Read\r\n");
+        return 0;
+    }
+    if (!DAC8571_BreakerAllow(hdac8571)) {
+        return 0;
+    }
+
+    bool held;
+    if (DAC8571_Lock(hdac8571, &held) != HAL_OK) {
+        return 0;
+    }
+
+    DAC8571_RecoverPending(hdac8571);
+    uint8_t received_data[3] = {0}; // Buffer for received data
+    DAC8571_STATS_BEGIN();
+    HAL_StatusTypeDef status = DAC8571_BUS(hdac8571, Receive)(
+            hdac8571,
+            hdac8571->address << 1| 0x01,  // адрес + бит чтения
+			received_data,
+            3,
+            DAC8571_TimeoutMs(hdac8571, 3)
+        );
+    DAC8571_STATS_END(hdac8571, sizeof(received_data), status);
+    DAC8571_BreakerRecord(hdac8571, status);
+    if (status == HAL_OK) {
+        hdac8571->lastError = DAC8571_OK;
+    }
+    DAC8571_Unlock(hdac8571, held);
+    //DEBUG_PRINT("Received data: 0x%02X 0x%02X 0x%02X \r\n", received_data[0], received_data[1], received_data[2]);
+
+    if (status != HAL_OK) {
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_READ_FAIL, hdac8571->address, 0, status);
+        DEBUG_PRINT("Error: I2C Read Failed from DAC8571 at address 0x%02X, ERROR: %s \r\n", hdac8571->address, HAL_StatusToString(status));
+        return 0;
+    }
+
+    uint16_t value = (received_data[0] << 8) | received_data[1]; // Combine high and low bytes
+
+    //DEBUG_PRINT("DAC8571_Read: 0x%04X\r\n", value);
+    return value;
+}
+
+
+
+HAL_StatusTypeDef DAC8571_SetVoltage(DAC8571_HandleTypeDef *hdac8571, float voltage) {
+    if (!hdac8571 || voltage < 0.0f || voltage > hdac8571->refVoltage) {
+        DEBUG_PRINT("Error: Invalid voltage parameter in DAC8571_SetVoltage\r\n");
+        return HAL_ERROR;
+    }
+
+    // One single-precision multiply by the cached reciprocal, rounded to nearest
+    uint32_t code = (uint32_t)(voltage * hdac8571->codesPerVolt + 0.5f);
+    return DAC8571_Write(hdac8571, DAC8571_Calibrated(hdac8571, (code > 0xFFFF) ? 0xFFFF : (uint16_t)code));
+}
+
+HAL_StatusTypeDef DAC8571_SetMillivolts(DAC8571_HandleTypeDef *hdac8571, uint32_t millivolts) {
+    if (!hdac8571 || millivolts > hdac8571->refMicrovolts / 1000) {
+        DEBUG_PRINT("Error: Invalid voltage parameter in DAC8571_SetMillivolts\r\n");
+        return HAL_ERROR;
+    }
+
+    return DAC8571_Write(hdac8571, DAC8571_Calibrated(hdac8571, DAC8571_MicrovoltsToCode(hdac8571, millivolts * 1000)));
+}
+
+HAL_StatusTypeDef DAC8571_SetMicrovolts(DAC8571_HandleTypeDef *hdac8571, uint32_t microvolts) {
+    if (!hdac8571 || microvolts > hdac8571->refMicrovolts) {
+        DEBUG_PRINT("Error: Invalid voltage parameter in DAC8571_SetMicrovolts\r\n");
+        return HAL_ERROR;
+    }
+
+    return DAC8571_Write(hdac8571, DAC8571_Calibrated(hdac8571, DAC8571_MicrovoltsToCode(hdac8571, microvolts)));
+}
+
+HAL_StatusTypeDef DAC8571_VoltsToCodes(DAC8571_HandleTypeDef *hdac8571, const float *volts, uint16_t *codes, uint32_t length) {
+    if (!hdac8571 || !volts || !codes) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_VoltsToCodes\r\n");
+        return HAL_ERROR;
+    }
+
+    DAC8571_VoltsToCodesKernel(hdac8571->codesPerVolt, volts, (uint8_t *)codes, length, false);
+    if (hdac8571->calEnabled) {
+        DAC8571_CalApplyBlock(hdac8571, (const uint8_t *)codes, (uint8_t *)codes, length, false);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_VoltsToFrames(DAC8571_HandleTypeDef *hdac8571, const float *volts, uint16_t length, uint8_t *frame, uint32_t frameSize) {
+    if (!hdac8571 || !volts || !frame || length == 0 || length > DAC8571_FRAME_MAX_SAMPLES) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_VoltsToFrames\r\n");
+        return HAL_ERROR;
+    }
+    if (frameSize < DAC8571_FRAME_SIZE(length)) {
+        hdac8571->lastError = DAC8571_BUFFER_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_BUFFER_OVERFLOW, hdac8571->address, length, HAL_ERROR);
+        DEBUG_PRINT("Error: Buffer overflow in DAC8571_VoltsToFrames\r\n");
+        return HAL_ERROR;
+    }
+
+    frame[0] = hdac8571->writeMode;
+    if (hdac8571->calEnabled) {
+        // Native order first; the calibration pass does the byte swap
+        DAC8571_VoltsToCodesKernel(hdac8571->codesPerVolt, volts, &frame[1], length, false);
+        DAC8571_CalApplyBlock(hdac8571, &frame[1], &frame[1], length, true);
+    } else {
+        DAC8571_VoltsToCodesKernel(hdac8571->codesPerVolt, volts, &frame[1], length, true);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_SetCalibration(DAC8571_HandleTypeDef *hdac8571, float gain, float offsetLsb) {
+    if (!hdac8571 || !(gain >= DAC8571_CAL_GAIN_MIN && gain <= DAC8571_CAL_GAIN_MAX) ||
+        !(offsetLsb >= -32768.0f && offsetLsb <= 32767.0f)) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_SetCalibration\r\n");
+        return HAL_ERROR;
+    }
+
+    hdac8571->calGain = (int32_t)(gain * 65536.0f + 0.5f);
+    hdac8571->calOffset = (int32_t)(offsetLsb * 65536.0f + ((offsetLsb < 0.0f) ? -0.5f : 0.5f));
+    hdac8571->calEnabled = 1;
+    hdac8571->cacheValid = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_SetInlTable(DAC8571_HandleTypeDef *hdac8571, const int16_t *table) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_SetInlTable\r\n");
+        return HAL_ERROR;
+    }
+
+    if (table) {
+        memcpy(hdac8571->calInl, table, sizeof(hdac8571->calInl));
+        hdac8571->calEnabled = 1;
+    }
+    hdac8571->calInlEnabled = (table != NULL);
+    hdac8571->cacheValid = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_ClearCalibration(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_ClearCalibration\r\n");
+        return HAL_ERROR;
+    }
+
+    hdac8571->calEnabled = 0;
+    hdac8571->calInlEnabled = 0;
+    hdac8571->calGain = 65536;
+    hdac8571->calOffset = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_CalibrateCodes(DAC8571_HandleTypeDef *hdac8571, uint16_t *codes, uint32_t length) {
+    if (!hdac8571 || !codes) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_CalibrateCodes\r\n");
+        return HAL_ERROR;
+    }
+
+    if (hdac8571->calEnabled) {
+        for (uint32_t i = 0; i < length; i++) {
+            codes[i] = DAC8571_CalApply(hdac8571, codes[i]);
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_SetReference(DAC8571_HandleTypeDef *hdac8571, float refVoltage) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_SetReference\r\n");
+        return HAL_ERROR;
+    }
+
+    if (refVoltage < DAC8571_REF_VOLTAGE_MIN || refVoltage > DAC8571_REF_VOLTAGE_MAX) {
+        DEBUG_PRINT("Error: Invalid reference voltage in DAC8571_SetReference\r\n");
+        return HAL_ERROR;
+    }
+
+    DAC8571_SetCodeScale(hdac8571, (uint32_t)(refVoltage * 1000000.0f + 0.5f));
+    return HAL_OK;
+}
+
+float DAC8571_GetReference(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetReference\r\n");
+        return 0.0f;
+    }
+    return hdac8571->refVoltage;
+}
+
+HAL_StatusTypeDef DAC8571_SetWriteMode(DAC8571_HandleTypeDef *hdac8571, uint8_t mode) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_SetWriteMode\r\n");
+        return HAL_ERROR;
+    }
+
+    switch (mode) {
+        case DAC8571_CMD_WRITE_TMP:
+        case DAC8571_CMD_WRITE_TMP_PWDN:
+        case DAC8571_CMD_WRITE_AND_UPDATE_DAC:
+        case DAC8571_CMD_WRITE_UPDATE_PWDN:
+        case DAC8571_CMD_UPDATE_FROM_TMP:
+        case DAC8571_CMD_BROADCAST_WRITE_TMP:
+        case DAC8571_CMD_BROADCAST_WRITE_UPDATE:
+        case DAC8571_CMD_BROADCAST_PWDN_ALL:
+            hdac8571->writeMode = mode;
+            return HAL_OK;
+
+        default:
+            DEBUG_PRINT("Error: Invalid mode in DAC8571_SetWriteMode: 0x%02X\r\n", mode);
+            return HAL_ERROR;
+    }
+}
+
+uint8_t DAC8571_GetWriteMode(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetWriteMode\r\n");
+        return 0;
+    }
+    return hdac8571->writeMode;
+}
+
+HAL_StatusTypeDef DAC8571_PowerMode(DAC8571_HandleTypeDef *hdac8571, uint8_t pdMode) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_PowerMode\r\n");
+        return HAL_ERROR;
+    }
+
+    uint16_t pdValue = 0;
+
+    switch (pdMode) {
+        case DAC8571_PD_LOW_POWER:   pdValue = (0b000 << 13); break;
+        case DAC8571_PD_FAST:        pdValue = (0b001 << 13); break;
+        case DAC8571_PD_1_KOHM:      pdValue = (0b010 << 13); break;
+        case DAC8571_PD_100_KOHM:    pdValue = (0b110 << 13); break;
+        case DAC8571_PD_HI_Z:        pdValue = (0b111 << 13); break;
+        default:
+            DEBUG_PRINT("Error: Invalid power-down mode in DAC8571_PowerMode\r\n");
+            return HAL_ERROR;
+    }
+
+    // One-off control byte: the handle's write mode is left as configured
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status == HAL_OK) {
+        hdac8571->cacheValid = 0;
+        status = DAC8571_WriteValue(hdac8571, DAC8571_CMD_WRITE_TMP_PWDN, pdValue);
+        DAC8571_Unlock(hdac8571, held);
+    }
+    return status;
+}
+
+
+HAL_StatusTypeDef DAC8571_WakeUp(DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_WakeUp\r\n");
+        return HAL_ERROR;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status == HAL_OK) {
+        hdac8571->cacheValid = 0;
+        status = DAC8571_WriteValue(hdac8571, hdac8571->writeMode, value);
+        DAC8571_Unlock(hdac8571, held);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Reset(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_Reset\r\n");
+        return HAL_ERROR;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status == HAL_OK) {
+        hdac8571->cacheValid = 0;
+        status = DAC8571_WriteValue(hdac8571, hdac8571->writeMode, 0);
+        DAC8571_Unlock(hdac8571, held);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Group_Init(DAC8571_GroupTypeDef *group) {
+    if (!group) {
+        DEBUG_PRINT("Error: Invalid group in DAC8571_Group_Init\r\n");
+        return HAL_ERROR;
+    }
+
+    for (uint8_t i = 0; i < DAC8571_GROUP_MAX_DEVICES; i++) {
+        group->members[i] = NULL;
+        group->pending[i] = 0;
+    }
+    group->count = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Group_Add(DAC8571_GroupTypeDef *group, DAC8571_HandleTypeDef *hdac8571) {
+    if (!group || !hdac8571 || !hdac8571->hi2c) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Group_Add\r\n");
+        return HAL_ERROR;
+    }
+
+    if (group->count >= DAC8571_GROUP_MAX_DEVICES) {
+        DEBUG_PRINT("Error: Group full in DAC8571_Group_Add\r\n");
+        return HAL_ERROR;
+    }
+
+    // A broadcast only reaches the bus it is sent on
+    if (group->count > 0 && group->members[0]->hi2c != hdac8571->hi2c) {
+        DEBUG_PRINT("Error: Group members must share one I2C bus\r\n");
+        return HAL_ERROR;
+    }
+
+    group->pending[group->count] = hdac8571->lastValue;
+    group->members[group->count++] = hdac8571;
+    return HAL_OK;
+}
+
+/**
+ * @brief Load every member's temporary register (caller holds the bus lock).
+ */
+static HAL_StatusTypeDef DAC8571_GroupLoad(DAC8571_GroupTypeDef *group, const uint16_t *values) {
+    for (uint8_t i = 0; i < group->count; i++) {
+        DAC8571_HandleTypeDef *hdac8571 = group->members[i];
+        uint8_t buffer[3] = {DAC8571_CMD_WRITE_TMP, (uint8_t)(values[i] >> 8), (uint8_t)(values[i] & 0xFF)};
+        hdac8571->cacheValid = 0;
+        if (!DAC8571_BreakerAllow(hdac8571)) {
+            return HAL_BUSY;
+        }
+
+        HAL_StatusTypeDef status = DAC8571_Transmit(hdac8571, buffer, sizeof(buffer));
+        if (status != HAL_OK) {
+            hdac8571->lastError = DAC8571_I2C_ERROR;
+            DAC8571_LOG_ERROR(DAC8571_EVT_WRITE_FAIL, hdac8571->address, values[i], status);
+            DEBUG_PRINT("Error: Failed to load value 0x%04X into DAC8571 at address 0x%02X. ERROR = %s \r\n", values[i], hdac8571->address, HAL_StatusToString(status));
+            return status;
+        }
+        group->pending[i] = values[i];
+    }
+    return HAL_OK;
+}
+
+/**
+ * @brief Send the broadcast update (caller holds the bus lock).
+ */
+static HAL_StatusTypeDef DAC8571_GroupUpdate(DAC8571_GroupTypeDef *group) {
+    // Data bytes are ignored by the broadcast update; every device latches on the final ACK
+    uint8_t buffer[3] = {DAC8571_CMD_BROADCAST_UPDATE, 0x00, 0x00};
+    DAC8571_STATS_BEGIN();
+    HAL_StatusTypeDef status = DAC8571_BUS(group->members[0], Transmit)(group->members[0], DAC8571_BROADCAST_ADDRESS << 1, buffer, sizeof(buffer), DAC8571_TimeoutMs(group->members[0], sizeof(buffer)));
+    DAC8571_STATS_END(group->members[0], sizeof(buffer), status);
+    if (status != HAL_OK) {
+        for (uint8_t i = 0; i < group->count; i++) {
+            group->members[i]->cacheValid = 0;
+            group->members[i]->lastError = DAC8571_I2C_ERROR;
+        }
+        DAC8571_LOG_ERROR(DAC8571_EVT_BROADCAST_FAIL, DAC8571_BROADCAST_ADDRESS, 0, status);
+        DEBUG_PRINT("Error: Broadcast update failed. ERROR = %s \r\n", HAL_StatusToString(status));
+        return status;
+    }
+
+    for (uint8_t i = 0; i < group->count; i++) {
+        group->members[i]->lastValue = group->pending[i];
+        group->members[i]->lastError = DAC8571_OK;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Group_Load(DAC8571_GroupTypeDef *group, const uint16_t *values) {
+    if (!group || !values || group->count == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Group_Load\r\n");
+        return HAL_ERROR;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(group->members[0], &held);
+    if (status == HAL_OK) {
+        status = DAC8571_GroupLoad(group, values);
+        DAC8571_Unlock(group->members[0], held);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Group_Update(DAC8571_GroupTypeDef *group) {
+    if (!group || group->count == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Group_Update\r\n");
+        return HAL_ERROR;
+    }
+
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(group->members[0], &held);
+    if (status == HAL_OK) {
+        status = DAC8571_GroupUpdate(group);
+        DAC8571_Unlock(group->members[0], held);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Group_Write(DAC8571_GroupTypeDef *group, const uint16_t *values) {
+    if (!group || !values || group->count == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Group_Write\r\n");
+        return HAL_ERROR;
+    }
+
+    // One lock for load and update: no other write lands between them
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(group->members[0], &held);
+    if (status == HAL_OK) {
+        status = DAC8571_GroupLoad(group, values);
+        if (status == HAL_OK) {
+            status = DAC8571_GroupUpdate(group);
+        }
+        DAC8571_Unlock(group->members[0], held);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Session_Begin(DAC8571_SessionTypeDef *session, I2C_HandleTypeDef *hi2c) {
+    if (!session || !hi2c) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Session_Begin\r\n");
+        return HAL_ERROR;
+    }
+
+    // The bus stays ours until DAC8571_Session_End; the START goes out with the first frame
+    session->open = 0;
+    session->locked = 0;
+    HAL_StatusTypeDef status = DAC8571_BusLock(DAC8571_FindBusSlot(hi2c, false), true);
+    if (status != HAL_OK) {
+        return status;
+    }
+#ifdef DAC8571_ENABLE_LOCKING
+    session->locked = 1;
+#endif
+    session->hi2c = hi2c;
+    session->last = NULL;
+    session->open = 1;
+    session->frames = 0;
+    return HAL_OK;
+}
+
+/**
+ * @brief Send one session frame: START for the first, repeated START afterwards, never STOP.
+ */
+static HAL_StatusTypeDef DAC8571_SessionFrame(DAC8571_SessionTypeDef *session, DAC8571_HandleTypeDef *hdac8571, uint8_t *buffer, uint16_t size) {
+    DAC8571_STATS_BEGIN();
+    HAL_StatusTypeDef status = DAC8571_SeqTransmit(hdac8571, hdac8571->address << 1, buffer, size,
+                                                   session->frames ? DAC8571_SEQ_RESTART : I2C_FIRST_FRAME);
+    DAC8571_STATS_END(hdac8571, size, status);
+
+    if (status != HAL_OK) {
+        // A NACK ends the sequence with a STOP; after a timeout the bus is still ours to release
+        if (status == HAL_TIMEOUT) {
+            DAC8571_SendStop(hdac8571);
+        }
+        session->open = 0;
+        hdac8571->cacheValid = 0;
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DAC8571_LOG_ERROR(DAC8571_EVT_WRITE_FAIL, hdac8571->address, size, status);
+        DEBUG_PRINT("Error: Session frame to DAC8571 at address 0x%02X failed. ERROR = %s \r\n", hdac8571->address, HAL_StatusToString(status));
+    } else {
+        session->frames++;
+        session->last = hdac8571;
+        hdac8571->lastError = DAC8571_OK;
+        DAC8571_CacheStore(hdac8571, buffer[0]);
+    }
+    DAC8571_BreakerRecord(hdac8571, status);
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Session_Write(DAC8571_SessionTypeDef *session, DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
+    if (!session || !hdac8571 || !session->open || hdac8571->hi2c != session->hi2c) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Session_Write\r\n");
+        return HAL_ERROR;
+    }
+    if (hdac8571->busy || !DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    uint8_t buffer[3] = {hdac8571->writeMode, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    HAL_StatusTypeDef status = DAC8571_SessionFrame(session, hdac8571, buffer, sizeof(buffer));
+    if (status == HAL_OK) {
+        hdac8571->lastValue = value;
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Session_WriteStream(DAC8571_SessionTypeDef *session, DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length) {
+    if (!session || !hdac8571 || !arr || length == 0 || !session->open || hdac8571->hi2c != session->hi2c) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_Session_WriteStream\r\n");
+        return HAL_ERROR;
+    }
+    if (hdac8571->busy || !DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
+
+    uint8_t buffer[1 + 2 * DAC8571_STREAM_MAX_SAMPLES];
+    buffer[0] = hdac8571->writeMode;
+
+    uint16_t sent = 0;
+    while (sent < length) {
+        uint16_t count = length - sent;
+        if (count > DAC8571_STREAM_MAX_SAMPLES) {
+            count = DAC8571_STREAM_MAX_SAMPLES;
+        }
+
+        uint8_t *p = &buffer[1];
+        for (uint16_t i = 0; i < count; i++) {
+            *p++ = (uint8_t)(arr[sent + i] >> 8);
+            *p++ = (uint8_t)(arr[sent + i] & 0xFF);
+        }
+
+        HAL_StatusTypeDef status = DAC8571_SessionFrame(session, hdac8571, buffer, (uint16_t)(1 + 2 * count));
+        if (status != HAL_OK) {
+            return status;
+        }
+        sent += count;
+        hdac8571->lastValue = arr[sent - 1];
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Session_End(DAC8571_SessionTypeDef *session) {
+    if (!session) {
+        DEBUG_PRINT("Error: Invalid session in DAC8571_Session_End\r\n");
+        return HAL_ERROR;
+    }
+
+    // Transports that batch frames (Linux i2c-dev) report errors when the STOP is sent
+    HAL_StatusTypeDef status = HAL_OK;
+    if (session->open && session->frames > 0 && session->last != NULL) {
+        status = DAC8571_SendStop(session->last);
+        if (status != HAL_OK) {
+            DAC8571_LOG_ERROR(DAC8571_EVT_WRITE_FAIL, 0, (uint16_t)session->frames, status);
+            DEBUG_PRINT("Error: Session of %lu frames failed. ERROR = %s \r\n", (unsigned long)session->frames, HAL_StatusToString(status));
         }
     }
-
-    if (!connected) {
-        DEBUG_PRINT("Error: DAC8571 not responding after %d attempts!\r\n", max_attempts);
-        //hdac8571->lastError = DAC8571_ERROR_NOT_CONNECTED;
-        return;
+    if (session->locked) {
+        DAC8571_BusUnlock(DAC8571_FindBusSlot(session->hi2c, false));
+        session->locked = 0;
     }
-
-    DEBUG_PRINT("DAC8571_Init successful\r\n");
+    session->open = 0;
+    return status;
 }
 
-HAL_StatusTypeDef DAC8571_Write(DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
+HAL_StatusTypeDef DAC8571_SetCacheMode(DAC8571_HandleTypeDef *hdac8571, uint8_t enable) {
     if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_Write\r\n");
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_SetCacheMode\r\n");
         return HAL_ERROR;
     }
 
-    uint8_t buffer[3] = {hdac8571->writeMode, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
-    //DEBUG_PRINT("Data on input: 0x%04X \r\n", value);
-    //DEBUG_PRINT("Data to send:  0x%02X 0x%02X 0x%02X\r\n", buffer[0], buffer[1], buffer[2]);
+    hdac8571->cacheEnabled = enable ? 1 : 0;
+    hdac8571->cacheValid = 0;
+    return HAL_OK;
+}
 
-    HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(hdac8571->hi2c, hdac8571->address << 1, buffer, sizeof(buffer), 100);
-    if (status != HAL_OK) {
-        hdac8571->lastError = DAC8571_I2C_ERROR;
-        DEBUG_PRINT("Error: Failed to write value 0x%04X to DAC8571 at address 0x%02X. ERROR = %s \r\n", value, hdac8571->address, HAL_StatusToString(status));
-        return status;
+HAL_StatusTypeDef DAC8571_InvalidateCache(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_InvalidateCache\r\n");
+        return HAL_ERROR;
     }
 
-    hdac8571->lastValue = value;
-    hdac8571->lastError = DAC8571_OK;
+    hdac8571->cacheValid = 0;
     return HAL_OK;
 }
 
-HAL_StatusTypeDef DAC8571_IsConnected(DAC8571_HandleTypeDef *hdac8571) {
-//    if (!hdac8571) {
-//        DEBUG_PRINT("Error: Invalid handle in DAC8571_IsConnected\r\n");
-//        return HAL_ERROR;
-//    }
-//
-//    HAL_StatusTypeDef status = DAC8571_Read(hdac8571);
-//    if (status != HAL_OK) {
-//        hdac8571->lastError = DAC8571_I2C_ERROR;
-//        DEBUG_PRINT("Error: DAC8571 not responding at address 0x%02X\r\n", hdac8571->address);
-//    }
-	if (!hdac8571) {
-		printf("DAC8571_IsConnected: invalid handle\r\n");
-		return HAL_ERROR;
-	}
-
-	HAL_StatusTypeDef status = HAL_I2C_IsDeviceReady(
-		hdac8571->hi2c,
-		hdac8571->address << 1,
-		1,
-		10
-	);
+uint32_t DAC8571_GetSuppressedWrites(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetSuppressedWrites\r\n");
+        return 0;
+    }
+    return hdac8571->suppressedWrites;
+}
 
-	if (status != HAL_OK) {
-		hdac8571->lastError = DAC8571_I2C_ERROR;
-		DEBUG_PRINT("Error: DAC8571 not responding at address 0x%02X\r\n", hdac8571->address);
-	}
+#ifdef DAC8571_ENABLE_STATS
+HAL_StatusTypeDef DAC8571_GetStats(DAC8571_HandleTypeDef *hdac8571, DAC8571_StatsTypeDef *stats) {
+    if (!hdac8571 || !stats) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_GetStats\r\n");
+        return HAL_ERROR;
+    }
 
-	//printf("DAC8571_IsConnected returned: %s (0x%02X)\r\n", HAL_StatusToString(status), (uint8_t)status);
-    return status;
+    *stats = hdac8571->stats;
+    stats->meanCycles = stats->transactions ? (uint32_t)(stats->totalCycles / stats->transactions) : 0;
+    return HAL_OK;
 }
 
-HAL_StatusTypeDef DAC8571_WriteArray(DAC8571_HandleTypeDef *hdac8571, uint16_t *arr, uint8_t length) {
-    if (!hdac8571 || !arr || length == 0) {
-        DEBUG_PRINT("Error: Invalid parameters in DAC8571_WriteArray\r\n");
+HAL_StatusTypeDef DAC8571_ResetStats(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_ResetStats\r\n");
         return HAL_ERROR;
     }
 
-    if (length > 14) {
-        hdac8571->lastError = DAC8571_BUFFER_ERROR;
-        DEBUG_PRINT("Error: Buffer overflow in DAC8571_WriteArray\r\n");
-        return HAL_ERROR;
+    DAC8571_StatsTypeDef *stats = &hdac8571->stats;
+    stats->transactions = 0;
+    stats->errors = 0;
+    stats->bytes = 0;
+    stats->minCycles = 0;
+    stats->maxCycles = 0;
+    stats->meanCycles = 0;
+    stats->totalCycles = 0;
+    for (uint8_t i = 0; i < DAC8571_STATS_BUCKETS; i++) {
+        stats->histogram[i] = 0;
     }
+    return HAL_OK;
+}
+#endif
 
-    HAL_StatusTypeDef status = HAL_OK;
-    for (uint8_t i = 0; i < length; i++) {
-        status = DAC8571_Write(hdac8571, arr[i]);
-        if (status != HAL_OK) {
-            return status;
-        }
+HAL_StatusTypeDef DAC8571_GetSnapshot(DAC8571_HandleTypeDef *hdac8571, DAC8571_SnapshotTypeDef *snapshot) {
+    if (!hdac8571 || !snapshot) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_GetSnapshot\r\n");
+        return HAL_ERROR;
     }
 
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status != HAL_OK) {
+        return status;
+    }
+    snapshot->lastValue = hdac8571->lastValue;
+    snapshot->writeMode = hdac8571->writeMode;
+    snapshot->lastError = hdac8571->lastError;
+    snapshot->busy = hdac8571->busy;
+    snapshot->cacheValid = hdac8571->cacheValid;
+    snapshot->hsActive = hdac8571->hsActive;
+    snapshot->initState = hdac8571->initState;
+    snapshot->breakerState = hdac8571->breakerState;
+    snapshot->suppressedWrites = hdac8571->suppressedWrites;
+    DAC8571_Unlock(hdac8571, held);
     return HAL_OK;
 }
 
-uint16_t DAC8571_Read(DAC8571_HandleTypeDef *hdac8571) {
-    if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_Read\r\n");
-        return 0;
+#ifdef DAC8571_ENABLE_LOCKING
+HAL_StatusTypeDef DAC8571_GetLockStats(I2C_HandleTypeDef *hi2c, DAC8571_LockStatsTypeDef *stats) {
+    DAC8571_BusSlotTypeDef *slot = DAC8571_FindBusSlot(hi2c, false);
+    if (!slot || !stats) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_GetLockStats\r\n");
+        return HAL_ERROR;
     }
 
-    uint8_t received_data[3] = {0}; // Buffer for received data
-    HAL_StatusTypeDef status = HAL_I2C_Master_Receive(
-            hdac8571->hi2c,
-            hdac8571->address << 1| 0x01,  // адрес + бит чтения
-			received_data,
-            3,
-            HAL_MAX_DELAY
-        );
-    //DEBUG_PRINT("Received data: 0x%02X 0x%02X 0x%02X \r\n", received_data[0], received_data[1], received_data[2]);
-
+    // Counters change only under the lock; this acquisition is not counted
+    HAL_StatusTypeDef status = DAC8571_BusLock(slot, true);
     if (status != HAL_OK) {
-        hdac8571->lastError = DAC8571_I2C_ERROR;
-        DEBUG_PRINT("Error: I2C Read Failed from DAC8571 at address 0x%02X, ERROR: %s \r\n", hdac8571->address, HAL_StatusToString(status));
-        return 0;
+        return status;
     }
+    slot->lockStats.acquisitions--;
+    *stats = slot->lockStats;
+    DAC8571_BusUnlock(slot);
+    return HAL_OK;
+}
+#endif
 
-    uint16_t value = (received_data[0] << 8) | received_data[1]; // Combine high and low bytes
-    hdac8571->lastError = DAC8571_OK;
+#if defined(DAC8571_ENABLE_HS) && ((DAC8571_HS_MASTER_ID & 0x01) || (DAC8571_HS_MASTER_ID > 0x07))
+#error "DAC8571_HS_MASTER_ID must be 0, 2, 4 or 6: the HAL clears bit 0 of the address byte"
+#endif
 
-    //DEBUG_PRINT("DAC8571_Read: 0x%04X\r\n", value);
-    return value;
-}
+HAL_StatusTypeDef DAC8571_HS_Begin(DAC8571_HandleTypeDef *hdac8571, uint32_t hsClockHz) {
+    if (!hdac8571 || hsClockHz == 0 || hsClockHz > DAC8571_HS_MAX_CLOCK_HZ || !DAC8571_BUS_IS_HAL(hdac8571)) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_HS_Begin\r\n");
+        return HAL_ERROR;
+    }
+#ifndef DAC8571_ENABLE_HS
+    DEBUG_PRINT("Error: High-speed mode not enabled (DAC8571_ENABLE_HS needs an HS-capable I2C port)\r\n");
+    return HAL_ERROR;
+#else
+    if (hdac8571->busy || hdac8571->hsActive) {
+        return HAL_BUSY;
+    }
+    if (!DAC8571_BreakerAllow(hdac8571)) {
+        return HAL_BUSY;
+    }
 
+    // The session keeps the bus lock until DAC8571_HS_End (released in DAC8571_HSExit)
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status != HAL_OK) {
+        return status;
+    }
+    hdac8571->hsLockHeld = held;
 
+    // The master code is never acknowledged; anything but a NACK means the bus is not ours
+    status = DAC8571_SeqTransmit(hdac8571, DAC8571_HS_MASTER_CODE | DAC8571_HS_MASTER_ID, NULL, 0, I2C_FIRST_FRAME);
+    if (status != HAL_ERROR || HAL_I2C_GetError(hdac8571->hi2c) != HAL_I2C_ERROR_AF) {
+        DAC8571_Unlock(hdac8571, hdac8571->hsLockHeld);
+        hdac8571->hsLockHeld = 0;
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DEBUG_PRINT("Error: High-speed master code not sent. ERROR = %s \r\n", HAL_StatusToString(status));
+        return (status == HAL_OK) ? HAL_ERROR : status;
+    }
 
-HAL_StatusTypeDef DAC8571_SetVoltage(DAC8571_HandleTypeDef *hdac8571, float voltage) {
-    if (!hdac8571 || voltage < 0.0f || voltage > DAC8571_REF_VOLTAGE) {
-        DEBUG_PRINT("Error: Invalid voltage parameter in DAC8571_SetVoltage\r\n");
+    // The F4 HAL answers any master NACK with a STOP, which drops the bus out of HS mode again
+    I2C_HandleTypeDef *hi2c = hdac8571->hi2c;
+    if ((hi2c->Instance->CR1 & I2C_CR1_STOP) || !__HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_BUSY)) {
+        DAC8571_Unlock(hdac8571, hdac8571->hsLockHeld);
+        hdac8571->hsLockHeld = 0;
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DEBUG_PRINT("Error: The HAL sent a STOP after the high-speed master code; HS mode needs an HS-capable port\r\n");
         return HAL_ERROR;
     }
 
-    uint16_t value = (uint16_t)((voltage / DAC8571_REF_VOLTAGE) * 65535);
-    return DAC8571_Write(hdac8571, value);
+    hdac8571->hsSavedClockHz = hdac8571->hi2c->Init.ClockSpeed;
+    hdac8571->hi2c->Init.ClockSpeed = hsClockHz;
+    status = HAL_I2C_Init(hdac8571->hi2c);
+    hdac8571->hsActive = 1;
+    if (status != HAL_OK) {
+        DAC8571_HSExit(hdac8571, true);
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DEBUG_PRINT("Error: I2C peripheral rejected %lu Hz. ERROR = %s \r\n", (unsigned long)hsClockHz, HAL_StatusToString(status));
+        return status;
+    }
+
+    hdac8571->busClockHz = hsClockHz;
+    hdac8571->lastError = DAC8571_OK;
+    return HAL_OK;
+#endif
 }
 
-HAL_StatusTypeDef DAC8571_SetWriteMode(DAC8571_HandleTypeDef *hdac8571, uint8_t mode) {
+HAL_StatusTypeDef DAC8571_HS_End(DAC8571_HandleTypeDef *hdac8571) {
     if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_SetWriteMode\r\n");
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_HS_End\r\n");
         return HAL_ERROR;
     }
+    if (hdac8571->hsActive) {
+        DAC8571_HSExit(hdac8571, true);
+    }
+    return HAL_OK;
+}
 
-    switch (mode) {
-        case DAC8571_CMD_WRITE_TMP:
-        case DAC8571_CMD_WRITE_TMP_PWDN:
-        case DAC8571_CMD_WRITE_AND_UPDATE_DAC:
-        case DAC8571_CMD_WRITE_UPDATE_PWDN:
-        case DAC8571_CMD_UPDATE_FROM_TMP:
-        case DAC8571_CMD_BROADCAST_WRITE_TMP:
-        case DAC8571_CMD_BROADCAST_WRITE_UPDATE:
-        case DAC8571_CMD_BROADCAST_PWDN_ALL:
-            hdac8571->writeMode = mode;
-            return HAL_OK;
-
-        default:
-            DEBUG_PRINT("Error: Invalid mode in DAC8571_SetWriteMode: 0x%02X\r\n", mode);
-            return HAL_ERROR;
+HAL_StatusTypeDef DAC8571_SetBusTiming(DAC8571_HandleTypeDef *hdac8571, uint32_t busClockHz, uint8_t slack) {
+    if (!hdac8571 || busClockHz == 0 || slack == 0) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_SetBusTiming\r\n");
+        return HAL_ERROR;
     }
+    hdac8571->busClockHz = busClockHz;
+    hdac8571->timeoutSlack = slack;
+    return HAL_OK;
 }
 
-uint8_t DAC8571_GetWriteMode(DAC8571_HandleTypeDef *hdac8571) {
+uint32_t DAC8571_GetTimeout(DAC8571_HandleTypeDef *hdac8571, uint16_t bytes) {
     if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetWriteMode\r\n");
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetTimeout\r\n");
         return 0;
     }
-    return hdac8571->writeMode;
+    return DAC8571_TimeoutMs(hdac8571, bytes);
 }
 
-HAL_StatusTypeDef DAC8571_PowerMode(DAC8571_HandleTypeDef *hdac8571, uint8_t pdMode) {
+uint8_t DAC8571_GetBreakerState(DAC8571_HandleTypeDef *hdac8571) {
     if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_PowerMode\r\n");
-        return HAL_ERROR;
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_GetBreakerState\r\n");
+        return DAC8571_BREAKER_CLOSED;
     }
+    return hdac8571->breakerState;
+}
 
-    hdac8571->writeMode = DAC8571_CMD_WRITE_TMP_PWDN;
-    uint16_t pdValue = 0;
-
-    switch (pdMode) {
-        case DAC8571_PD_LOW_POWER:   pdValue = (0b000 << 13); break;
-        case DAC8571_PD_FAST:        pdValue = (0b001 << 13); break;
-        case DAC8571_PD_1_KOHM:      pdValue = (0b010 << 13); break;
-        case DAC8571_PD_100_KOHM:    pdValue = (0b110 << 13); break;
-        case DAC8571_PD_HI_Z:        pdValue = (0b111 << 13); break;
-        default:
-            DEBUG_PRINT("Error: Invalid power-down mode in DAC8571_PowerMode\r\n");
-            return HAL_ERROR;
+HAL_StatusTypeDef DAC8571_ResetBreaker(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571) {
+        DEBUG_PRINT("Error: Invalid handle in DAC8571_ResetBreaker\r\n");
+        return HAL_ERROR;
     }
-    return DAC8571_Write(hdac8571, pdValue);
+    hdac8571->breakerState = DAC8571_BREAKER_CLOSED;
+    hdac8571->consecutiveErrors = 0;
+    return HAL_OK;
 }
 
+HAL_StatusTypeDef DAC8571_SetRecoveryPins(DAC8571_HandleTypeDef *hdac8571, GPIO_TypeDef *sclPort, uint16_t sclPin, GPIO_TypeDef *sdaPort, uint16_t sdaPin) {
+    if (!hdac8571 || (sclPort && !sdaPort)) {
+        DEBUG_PRINT("Error: Invalid parameters in DAC8571_SetRecoveryPins\r\n");
+        return HAL_ERROR;
+    }
+    hdac8571->sclPort = sclPort;
+    hdac8571->sclPin = sclPin;
+    hdac8571->sdaPort = sdaPort;
+    hdac8571->sdaPin = sdaPin;
+    return HAL_OK;
+}
 
-HAL_StatusTypeDef DAC8571_WakeUp(DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
-    if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_WakeUp\r\n");
+HAL_StatusTypeDef DAC8571_BusRecover(DAC8571_HandleTypeDef *hdac8571) {
+    if (!hdac8571 || !hdac8571->sclPort || !hdac8571->sdaPort) {
+        DEBUG_PRINT("Error: Bus recovery pins not set in DAC8571_BusRecover\r\n");
         return HAL_ERROR;
     }
+    if (hdac8571->busy) {
+        return HAL_BUSY;
+    }
 
-    return DAC8571_Write(hdac8571, value);
+    bool held;
+    HAL_StatusTypeDef status = DAC8571_Lock(hdac8571, &held);
+    if (status == HAL_OK) {
+        status = DAC8571_RecoverBus(hdac8571);
+        DAC8571_Unlock(hdac8571, held);
+    }
+    return status;
 }
 
-HAL_StatusTypeDef DAC8571_Reset(DAC8571_HandleTypeDef *hdac8571) {
-    if (!hdac8571) {
-        DEBUG_PRINT("Error: Invalid handle in DAC8571_Reset\r\n");
-        return HAL_ERROR;
+/**
+ * @brief Clock a stuck slave free and re-initialize the peripheral (caller holds the bus lock).
+ */
+static HAL_StatusTypeDef DAC8571_RecoverBus(DAC8571_HandleTypeDef *hdac8571) {
+    // Take the pins away from the peripheral: SCL open-drain output, SDA input
+    HAL_I2C_DeInit(hdac8571->hi2c);
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin = hdac8571->sdaPin;
+    gpio.Mode = GPIO_MODE_INPUT;
+    gpio.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(hdac8571->sdaPort, &gpio);
+    HAL_GPIO_WritePin(hdac8571->sclPort, hdac8571->sclPin, GPIO_PIN_SET);
+    gpio.Pin = hdac8571->sclPin;
+    gpio.Mode = GPIO_MODE_OUTPUT_OD;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(hdac8571->sclPort, &gpio);
+
+    // A slave stuck mid-byte releases SDA after at most 9 clocks (8 data bits + ACK)
+    uint8_t pulses = 0;
+    while (pulses < DAC8571_RECOVERY_CLOCKS && HAL_GPIO_ReadPin(hdac8571->sdaPort, hdac8571->sdaPin) == GPIO_PIN_RESET) {
+        HAL_GPIO_WritePin(hdac8571->sclPort, hdac8571->sclPin, GPIO_PIN_RESET);
+        DAC8571_DelayUs(5);
+        HAL_GPIO_WritePin(hdac8571->sclPort, hdac8571->sclPin, GPIO_PIN_SET);
+        DAC8571_DelayUs(5);
+        pulses++;
+    }
+
+    // STOP condition: SDA rises while SCL is high
+    HAL_GPIO_WritePin(hdac8571->sclPort, hdac8571->sclPin, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(hdac8571->sdaPort, hdac8571->sdaPin, GPIO_PIN_RESET);
+    gpio.Pin = hdac8571->sdaPin;
+    HAL_GPIO_Init(hdac8571->sdaPort, &gpio);
+    DAC8571_DelayUs(5);
+    HAL_GPIO_WritePin(hdac8571->sclPort, hdac8571->sclPin, GPIO_PIN_SET);
+    DAC8571_DelayUs(5);
+    HAL_GPIO_WritePin(hdac8571->sdaPort, hdac8571->sdaPin, GPIO_PIN_SET);
+    DAC8571_DelayUs(5);
+
+    bool released = (HAL_GPIO_ReadPin(hdac8571->sdaPort, hdac8571->sdaPin) == GPIO_PIN_SET);
+
+    // HAL_I2C_Init -> HAL_I2C_MspInit returns the pins to the peripheral
+    HAL_StatusTypeDef status = HAL_I2C_Init(hdac8571->hi2c);
+    if (status == HAL_OK && !released) {
+        status = HAL_ERROR;
     }
 
-    return DAC8571_Write(hdac8571, 0);
+    hdac8571->busRecoveries++;
+    hdac8571->recoveryPending = 0;
+    hdac8571->cacheValid = 0;
+    DAC8571_LOG_WARN(DAC8571_EVT_BUS_RECOVERY, hdac8571->address, pulses, status);
+    if (status != HAL_OK) {
+        hdac8571->lastError = DAC8571_I2C_ERROR;
+        DEBUG_PRINT("Error: I2C bus recovery failed, SDA still held low\r\n");
+    }
+    return status;
 }
 
 int DAC8571_GetLastError(DAC8571_HandleTypeDef *hdac8571) {
@@ -319,8 +2196,8 @@ void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571) {
     printf("\r\n[1] Voltage Write Tests\r\n-----------------------------------\r\n");
     for (size_t i = 0; i < sizeof(voltages) / sizeof(voltages[0]); i++) {
         status = DAC8571_SetVoltage(hdac8571, voltages[i]);
-        if ((voltages[i] >= 0.0f && voltages[i] <= DAC8571_REF_VOLTAGE && status == HAL_OK) ||
-            ((voltages[i] < 0.0f || voltages[i] > DAC8571_REF_VOLTAGE) && status != HAL_OK)) {
+        if ((voltages[i] >= 0.0f && voltages[i] <= hdac8571->refVoltage && status == HAL_OK) ||
+            ((voltages[i] < 0.0f || voltages[i] > hdac8571->refVoltage) && status != HAL_OK)) {
             printf("[PASSED] SetVoltage(%.2fV)\r\n", voltages[i]);
             passedTests++;
         } else {
@@ -330,6 +2207,7 @@ void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571) {
     }
 
     printf("\r\n[2] Write Mode Tests\r\n-----------------------------------\r\n");
+    uint8_t savedMode = DAC8571_GetWriteMode(hdac8571);
     for (size_t i = 0; i < sizeof(allWriteModes); i++) {
         status = DAC8571_SetWriteMode(hdac8571, allWriteModes[i]);
         if ((allWriteModes[i] <= DAC8571_CMD_BROADCAST_PWDN_ALL && status == HAL_OK) ||
@@ -341,6 +2219,7 @@ void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571) {
             failedTests++;
         }
     }
+    DAC8571_SetWriteMode(hdac8571, savedMode);
 
     printf("\r\n[3] Power Mode Tests\r\n-----------------------------------\r\n");
     for (size_t i = 0; i < sizeof(powerModes); i++) {
@@ -387,6 +2266,24 @@ void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571) {
     uint16_t readVal = DAC8571_Read(hdac8571);
     printf("Read Value: 0x%04X\r\n", readVal);
 
+    // The STOP at the end of a session has to go out after the last frame has completed
+    DAC8571_SessionTypeDef session;
+    status = DAC8571_Session_Begin(&session, hdac8571->hi2c);
+    if (status == HAL_OK) {
+        status = DAC8571_Session_Write(&session, hdac8571, 0x4000);
+        HAL_StatusTypeDef endStatus = DAC8571_Session_End(&session);
+        if (status == HAL_OK) {
+            status = endStatus;
+        }
+    }
+    if (status == HAL_OK) {
+        printf("[PASSED] Session(STOP at end)\r\n");
+        passedTests++;
+    } else {
+        printf("[FAILED] Session(STOP at end)\r\n");
+        failedTests++;
+    }
+
     status = DAC8571_Reset(hdac8571);
     if (status == HAL_OK) {
         printf("[PASSED] Reset\r\n");
@@ -406,7 +2303,44 @@ void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571) {
         failedTests++;
     }
 
-    printf("\r\n[7] Get Functions\r\n-----------------------------------\r\n");
+    printf("\r\n[7] Batch Conversion Tests (%s)\r\n-----------------------------------\r\n", DAC8571_VOLTS_KERNEL);
+    // Edges, half-LSB boundaries and a sweep past both ends; 1 + 2 * 64 + 2 inputs leave a kernel tail
+    float batchVolts[1 + 2 * 64 + 2];
+    uint16_t batchCodes[sizeof(batchVolts) / sizeof(batchVolts[0])];
+    uint8_t batchRef[2 * sizeof(batchVolts) / sizeof(batchVolts[0])];
+    uint8_t batchFrame[DAC8571_FRAME_SIZE(sizeof(batchVolts) / sizeof(batchVolts[0]))];
+    const uint16_t batchCount = sizeof(batchVolts) / sizeof(batchVolts[0]);
+    const float lsb = hdac8571->refVoltage / 65535.0f;
+    batchVolts[0] = 0.0f / 0.0f;
+    for (uint16_t i = 1; i <= 64; i++) {
+        batchVolts[2 * i - 1] = (float)(i * 1021u) * lsb + 0.5f * lsb;
+        batchVolts[2 * i] = -0.1f + (hdac8571->refVoltage + 0.2f) * i / 64.0f;
+    }
+    batchVolts[batchCount - 2] = -1.0f / 0.0f;
+    batchVolts[batchCount - 1] = hdac8571->refVoltage;
+
+    DAC8571_VoltsToCodesScalar(hdac8571->codesPerVolt, batchVolts, batchRef, batchCount, false);
+    status = DAC8571_VoltsToCodes(hdac8571, batchVolts, batchCodes, batchCount);
+    if (status == HAL_OK && memcmp(batchCodes, batchRef, sizeof(batchCodes)) == 0 &&
+        batchCodes[0] == 0x0000 && batchCodes[batchCount - 1] == 0xFFFF) {
+        printf("[PASSED] VoltsToCodes(matches scalar)\r\n");
+        passedTests++;
+    } else {
+        printf("[FAILED] VoltsToCodes(matches scalar)\r\n");
+        failedTests++;
+    }
+
+    DAC8571_VoltsToCodesScalar(hdac8571->codesPerVolt, batchVolts, batchRef, batchCount, true);
+    status = DAC8571_VoltsToFrames(hdac8571, batchVolts, batchCount, batchFrame, sizeof(batchFrame));
+    if (status == HAL_OK && batchFrame[0] == hdac8571->writeMode && memcmp(&batchFrame[1], batchRef, sizeof(batchRef)) == 0) {
+        printf("[PASSED] VoltsToFrames(wire order)\r\n");
+        passedTests++;
+    } else {
+        printf("[FAILED] VoltsToFrames(wire order)\r\n");
+        failedTests++;
+    }
+
+    printf("\r\n[8] Get Functions\r\n-----------------------------------\r\n");
     printf("GetAddress: 0x%02X\r\n", DAC8571_GetAddress(hdac8571));
     printf("GetWriteMode: 0x%02X\r\n", DAC8571_GetWriteMode(hdac8571));
     printf("GetLastError: %d\r\n", DAC8571_GetLastError(hdac8571));
@@ -420,6 +2354,185 @@ void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571) {
 
 }
 
+/**
+ * @brief Stream samples in DAC8571_STREAM_MAX_SAMPLES bursts, for the benchmark.
+ * @return Elapsed milliseconds, or UINT32_MAX on failure.
+ */
+static uint32_t DAC8571_BenchmarkStream(DAC8571_HandleTypeDef *hdac8571, const uint16_t *pattern, uint32_t samples) {
+    uint32_t start = HAL_GetTick();
+    uint32_t remaining = samples;
+    while (remaining > 0) {
+        uint16_t count = (remaining > DAC8571_STREAM_MAX_SAMPLES) ? DAC8571_STREAM_MAX_SAMPLES : (uint16_t)remaining;
+        if (DAC8571_WriteStream(hdac8571, pattern, count) != HAL_OK) {
+            printf("[FAILED] WriteStream at sample %lu\r\n", (unsigned long)(samples - remaining));
+            return UINT32_MAX;
+        }
+        remaining -= count;
+    }
+    return HAL_GetTick() - start;
+}
+
+/**
+ * @brief Measures write throughput (samples per second) of the single-sample and streaming paths.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param samples Number of samples to write with each method.
+ */
+void DAC8571_Benchmark(DAC8571_HandleTypeDef *hdac8571, uint32_t samples) {
+    uint16_t pattern[DAC8571_STREAM_MAX_SAMPLES];
+    for (uint16_t i = 0; i < DAC8571_STREAM_MAX_SAMPLES; i++) {
+        pattern[i] = (uint16_t)(i * (65535u / DAC8571_STREAM_MAX_SAMPLES));
+    }
+
+    printf("\r\n===================================\r\n");
+    printf("        DAC8571 BENCHMARK\r\n");
+    printf("===================================\r\n");
+
+    // Per-sample transactions (what DAC8571_WriteArray does)
+    uint32_t start = HAL_GetTick();
+    for (uint32_t i = 0; i < samples; i++) {
+        if (DAC8571_Write(hdac8571, pattern[i % DAC8571_STREAM_MAX_SAMPLES]) != HAL_OK) {
+            printf("[FAILED] Write at sample %lu\r\n", (unsigned long)i);
+            return;
+        }
+    }
+    uint32_t singleMs = HAL_GetTick() - start;
+
+    // Per-sample frames joined by repeated STARTs
+    DAC8571_SessionTypeDef session;
+    if (DAC8571_Session_Begin(&session, hdac8571->hi2c) != HAL_OK) {
+        printf("[FAILED] Session_Begin\r\n");
+        return;
+    }
+    start = HAL_GetTick();
+    for (uint32_t i = 0; i < samples; i++) {
+        if (DAC8571_Session_Write(&session, hdac8571, pattern[i % DAC8571_STREAM_MAX_SAMPLES]) != HAL_OK) {
+            // Release the bus lock and send the STOP before bailing out
+            DAC8571_Session_End(&session);
+            printf("[FAILED] Session_Write at sample %lu\r\n", (unsigned long)i);
+            return;
+        }
+    }
+    if (DAC8571_Session_End(&session) != HAL_OK) {
+        printf("[FAILED] Session_End\r\n");
+        return;
+    }
+    uint32_t sessionMs = HAL_GetTick() - start;
+
+    // Burst transactions
+    uint32_t streamMs = DAC8571_BenchmarkStream(hdac8571, pattern, samples);
+    if (streamMs == UINT32_MAX) {
+        return;
+    }
+
+    // Burst transactions replayed from a buffer encoded once
+    uint8_t frame[DAC8571_FRAME_SIZE(DAC8571_STREAM_MAX_SAMPLES)];
+    uint32_t cycles = DAC8571_CycleCount();
+    DAC8571_EncodeFrames(hdac8571, pattern, DAC8571_STREAM_MAX_SAMPLES, frame, sizeof(frame));
+    uint32_t encodeCycles = DAC8571_CycleCount() - cycles;
+    start = HAL_GetTick();
+    for (uint32_t sent = 0; sent < samples; sent += DAC8571_STREAM_MAX_SAMPLES) {
+        uint32_t count = (samples - sent > DAC8571_STREAM_MAX_SAMPLES) ? DAC8571_STREAM_MAX_SAMPLES : samples - sent;
+        if (DAC8571_WriteFrames(hdac8571, frame, (uint16_t)DAC8571_FRAME_SIZE(count)) != HAL_OK) {
+            printf("[FAILED] WriteFrames at sample %lu\r\n", (unsigned long)sent);
+            return;
+        }
+    }
+    uint32_t framesMs = HAL_GetTick() - start;
+
+    printf("Samples: %lu\r\n", (unsigned long)samples);
+    printf("Write:       %lu ms, %lu samples/s\r\n", (unsigned long)singleMs,
+           (unsigned long)(singleMs ? (uint64_t)samples * 1000u / singleMs : 0));
+    printf("Session:     %lu ms, %lu samples/s\r\n", (unsigned long)sessionMs,
+           (unsigned long)(sessionMs ? (uint64_t)samples * 1000u / sessionMs : 0));
+    printf("WriteStream: %lu ms, %lu samples/s\r\n", (unsigned long)streamMs,
+           (unsigned long)(streamMs ? (uint64_t)samples * 1000u / streamMs : 0));
+    printf("WriteFrames: %lu ms, %lu samples/s (encoding %lu %s per burst, paid once)\r\n", (unsigned long)framesMs,
+           (unsigned long)(framesMs ? (uint64_t)samples * 1000u / framesMs : 0), (unsigned long)encodeCycles, DAC8571_CYCLE_UNIT);
+
+    // Burst transactions in a high-speed session (repeated START, no STOP between bursts)
+    if (DAC8571_HS_Begin(hdac8571, DAC8571_HS_MAX_CLOCK_HZ) == HAL_OK) {
+        uint32_t hsMs = DAC8571_BenchmarkStream(hdac8571, pattern, samples);
+        DAC8571_HS_End(hdac8571);
+        if (hsMs == UINT32_MAX) {
+            return;
+        }
+        printf("WriteStream (HS %lu Hz): %lu ms, %lu samples/s\r\n", (unsigned long)DAC8571_HS_MAX_CLOCK_HZ, (unsigned long)hsMs,
+               (unsigned long)(hsMs ? (uint64_t)samples * 1000u / hsMs : 0));
+    } else {
+        printf("WriteStream (HS): not available on this bus\r\n");
+    }
+
+    // Voltage-to-code conversion: legacy double math against the cached-factor paths
+    const uint32_t conversions = 1000;
+    volatile uint16_t sink = 0;
+    volatile float voltage = 0.0f;
+    const float step = hdac8571->refVoltage / conversions;
+
+    cycles = DAC8571_CycleCount();
+    for (uint32_t i = 0; i < conversions; i++) {
+        voltage = i * step;
+        sink = (uint16_t)((voltage / DAC8571_REF_VOLTAGE) * 65535);
+    }
+    uint32_t doubleCycles = DAC8571_CycleCount() - cycles;
+
+    cycles = DAC8571_CycleCount();
+    for (uint32_t i = 0; i < conversions; i++) {
+        voltage = i * step;
+        sink = DAC8571_MicrovoltsToCode(hdac8571, (uint32_t)(voltage * 1000000.0f + 0.5f));
+    }
+    uint32_t fixedCycles = DAC8571_CycleCount() - cycles;
+
+    cycles = DAC8571_CycleCount();
+    for (uint32_t i = 0; i < conversions; i++) {
+        voltage = i * step;
+        sink = (uint16_t)(voltage * hdac8571->codesPerVolt + 0.5f);
+    }
+    uint32_t floatCycles = DAC8571_CycleCount() - cycles;
+    (void)sink;
+
+    float batch[DAC8571_STREAM_MAX_SAMPLES];
+    uint16_t batchCodes[DAC8571_STREAM_MAX_SAMPLES];
+    for (uint16_t i = 0; i < DAC8571_STREAM_MAX_SAMPLES; i++) {
+        batch[i] = i * hdac8571->refVoltage / DAC8571_STREAM_MAX_SAMPLES;
+    }
+    cycles = DAC8571_CycleCount();
+    for (uint32_t i = 0; i < conversions; i += DAC8571_STREAM_MAX_SAMPLES) {
+        DAC8571_VoltsToCodes(hdac8571, batch, batchCodes, DAC8571_STREAM_MAX_SAMPLES);
+    }
+    uint32_t batchCycles = DAC8571_CycleCount() - cycles;
+    uint32_t batchConversions = (conversions + DAC8571_STREAM_MAX_SAMPLES - 1) / DAC8571_STREAM_MAX_SAMPLES * DAC8571_STREAM_MAX_SAMPLES;
+
+    // Calibration on a copy of the handle, so the device's own coefficients are untouched
+    DAC8571_HandleTypeDef calibrated = *hdac8571;
+    int16_t inl[DAC8571_CAL_INL_POINTS];
+    for (uint16_t i = 0; i < DAC8571_CAL_INL_POINTS; i++) {
+        inl[i] = (int16_t)((int32_t)i * (DAC8571_CAL_INL_POINTS - 1 - i) / 8);
+    }
+    DAC8571_SetCalibration(&calibrated, 1.0012f, -3.25f);
+    cycles = DAC8571_CycleCount();
+    for (uint32_t i = 0; i < conversions; i += DAC8571_STREAM_MAX_SAMPLES) {
+        DAC8571_CalibrateCodes(&calibrated, batchCodes, DAC8571_STREAM_MAX_SAMPLES);
+    }
+    uint32_t gainCycles = DAC8571_CycleCount() - cycles;
+    DAC8571_SetInlTable(&calibrated, inl);
+    cycles = DAC8571_CycleCount();
+    for (uint32_t i = 0; i < conversions; i += DAC8571_STREAM_MAX_SAMPLES) {
+        DAC8571_CalibrateCodes(&calibrated, batchCodes, DAC8571_STREAM_MAX_SAMPLES);
+    }
+    uint32_t inlCycles = DAC8571_CycleCount() - cycles;
+
+    printf("Conversion (double): %lu %s/call\r\n", (unsigned long)(doubleCycles / conversions), DAC8571_CYCLE_UNIT);
+    printf("Conversion (fixed):  %lu %s/call\r\n", (unsigned long)(fixedCycles / conversions), DAC8571_CYCLE_UNIT);
+    printf("Conversion (float):  %lu %s/call\r\n", (unsigned long)(floatCycles / conversions), DAC8571_CYCLE_UNIT);
+    printf("Conversion (batch, %s): %lu.%02lu %s/value\r\n", DAC8571_VOLTS_KERNEL, (unsigned long)(batchCycles / batchConversions),
+           (unsigned long)(batchCycles * 100u / batchConversions % 100u), DAC8571_CYCLE_UNIT);
+    printf("Calibration (gain/offset): %lu.%02lu %s/value\r\n", (unsigned long)(gainCycles / batchConversions),
+           (unsigned long)(gainCycles * 100u / batchConversions % 100u), DAC8571_CYCLE_UNIT);
+    printf("Calibration (+INL table):  %lu.%02lu %s/value\r\n", (unsigned long)(inlCycles / batchConversions),
+           (unsigned long)(inlCycles * 100u / batchConversions % 100u), DAC8571_CYCLE_UNIT);
+    printf("===================================\r\n");
+}
+
 const char* HAL_StatusToString(HAL_StatusTypeDef status) {
     switch (status) {
         case HAL_OK:       return "HAL_OK";
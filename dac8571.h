@@ -16,10 +16,25 @@ extern "C" {
 #include "stm32f4xx_hal.h"
 #include <stdint.h>
 
+// Build options and RTOS hooks in one place, e.g. -DDAC8571_CONFIG_FILE='"dac8571_config.h"'
+#ifdef DAC8571_CONFIG_FILE
+#include DAC8571_CONFIG_FILE
+#endif
+
 /**
  * @brief Reference voltage for DAC8571 (in volts).
  */
-#define DAC8571_REF_VOLTAGE     2.5 ///< Default reference voltage (adjust as needed)
+#define DAC8571_REF_VOLTAGE     2.5 ///< Default reference voltage used by DAC8571_Init (adjust as needed)
+#define DAC8571_REF_VOLTAGE_MIN 0.5f ///< Lowest accepted per-handle reference voltage
+#define DAC8571_REF_VOLTAGE_MAX 5.5f ///< Highest accepted per-handle reference voltage (VDD max)
+
+/**
+ * @brief Calibration limits (DAC8571_SetCalibration, DAC8571_SetInlTable).
+ */
+#define DAC8571_CAL_GAIN_MIN    0.5f ///< Lowest accepted gain correction
+#define DAC8571_CAL_GAIN_MAX    1.5f ///< Highest accepted gain correction
+#define DAC8571_CAL_INL_SHIFT   12   ///< INL table spacing: one point every 2^12 codes
+#define DAC8571_CAL_INL_POINTS  ((65536 >> DAC8571_CAL_INL_SHIFT) + 1) ///< INL table entries (codes 0, 4096, ..., 65536)
 
 /**
  * @brief Power-down modes for DAC8571.
@@ -37,6 +52,30 @@ extern "C" {
 #define DAC8571_I2C_ERROR           0x81 ///< I2C communication error
 #define DAC8571_ADDRESS_ERROR       0x82 ///< Invalid address error
 #define DAC8571_BUFFER_ERROR        0x83 ///< Buffer overflow error
+#define DAC8571_BREAKER_ERROR       0x84 ///< Rejected without bus access: circuit breaker open
+
+/**
+ * @brief Maximum number of samples packed into a single streaming I2C transaction.
+ */
+#ifndef DAC8571_STREAM_MAX_SAMPLES
+#define DAC8571_STREAM_MAX_SAMPLES  64 ///< Burst length (transmit buffer is 1 + 2 * N bytes)
+#endif
+
+/**
+ * @brief Asynchronous (DMA) transfer limits.
+ */
+#ifndef DAC8571_ASYNC_MAX_SAMPLES
+#define DAC8571_ASYNC_MAX_SAMPLES   DAC8571_STREAM_MAX_SAMPLES ///< Samples per asynchronous burst (per-handle buffer)
+#endif
+#ifndef DAC8571_MAX_BUSES
+#define DAC8571_MAX_BUSES           3 ///< Number of I2C buses with simultaneous asynchronous transfers
+#endif
+
+/**
+ * @brief Pre-encoded frame buffers (DAC8571_EncodeFrames): control byte, then big-endian samples.
+ */
+#define DAC8571_FRAME_SIZE(n)       (1U + 2U * (uint32_t)(n)) ///< Bytes of a frame buffer holding n samples
+#define DAC8571_FRAME_MAX_SAMPLES   32767U ///< Samples per frame buffer (transfer length is 16-bit)
 
 /**
  * @brief Control byte commands for DAC8571.
@@ -51,18 +90,280 @@ extern "C" {
 #define DAC8571_CMD_BROADCAST_WRITE_UPDATE 0x31 ///< Broadcast: write and update all DACs
 #define DAC8571_CMD_BROADCAST_PWDN_ALL     0x33 ///< Broadcast: power-down all DACs
 
+/**
+ * @brief Device detection during initialization.
+ */
+#ifndef DAC8571_INIT_ATTEMPTS
+#define DAC8571_INIT_ATTEMPTS       5  ///< Probe attempts before a device is reported absent
+#endif
+#ifndef DAC8571_INIT_RETRY_MS
+#define DAC8571_INIT_RETRY_MS       25 ///< Delay between probe attempts (ms)
+#endif
+
+#define DAC8571_INIT_IDLE           0x00 ///< Not initialized
+#define DAC8571_INIT_PROBING        0x01 ///< Non-blocking init in progress
+#define DAC8571_INIT_READY          0x02 ///< Device answered
+#define DAC8571_INIT_ABSENT         0x03 ///< Device did not answer after DAC8571_INIT_ATTEMPTS probes
 
 /**
- * @brief Handle structure for the DAC8571 digital-to-analog converter.
+ * @brief Blocking transfer timeouts, derived from the bus clock and the transaction length.
+ */
+#ifndef DAC8571_TIMEOUT_SLACK
+#define DAC8571_TIMEOUT_SLACK       4 ///< Timeout as a multiple of the nominal transaction time
+#endif
+#ifndef DAC8571_TIMEOUT_MIN_MS
+#define DAC8571_TIMEOUT_MIN_MS      2 ///< Lower bound (HAL timeouts have 1 ms tick granularity)
+#endif
+
+/**
+ * @brief High-speed (3.4 MHz) mode.
+ * @details Off unless DAC8571_ENABLE_HS is defined. Define it only for an I2C controller and HAL
+ *          port that keep the bus after the NACKed master code and can clock SCL above 400 kHz.
+ *          The stock STM32F4 HAL does neither, so leave it undefined there: DAC8571_HS_Begin
+ *          then returns HAL_ERROR.
+ */
+#define DAC8571_HS_MASTER_CODE      0x08    ///< Master code 00001xxx, sent in F/S mode before switching to HS
+#ifndef DAC8571_HS_MASTER_ID
+#define DAC8571_HS_MASTER_ID        0x00    ///< xxx bits of the master code: 0, 2, 4 or 6 (the HAL clears bit 0)
+#endif
+#define DAC8571_HS_MAX_CLOCK_HZ     3400000U ///< Fastest HS-mode SCL supported by the DAC8571
+
+/**
+ * @brief Circuit breaker for failing devices.
+ * @details After DAC8571_BREAKER_THRESHOLD consecutive failed transactions the breaker opens and
+ *          transfers return HAL_BUSY immediately. After DAC8571_BREAKER_COOLDOWN_MS one trial
+ *          transfer is let through (half-open); success closes the breaker, failure reopens it.
+ */
+#ifndef DAC8571_BREAKER_THRESHOLD
+#define DAC8571_BREAKER_THRESHOLD   3   ///< Consecutive errors that open the breaker
+#endif
+#ifndef DAC8571_BREAKER_COOLDOWN_MS
+#define DAC8571_BREAKER_COOLDOWN_MS 100 ///< Time the breaker stays open before a trial transfer (ms)
+#endif
+#ifndef DAC8571_RECOVERY_CLOCKS
+#define DAC8571_RECOVERY_CLOCKS     9   ///< SCL pulses clocked out to release a slave holding SDA low
+#endif
+
+#define DAC8571_BREAKER_CLOSED      0x00 ///< Normal operation
+#define DAC8571_BREAKER_OPEN        0x01 ///< Failing fast until the cooldown expires
+#define DAC8571_BREAKER_HALF_OPEN   0x02 ///< One trial transfer allowed
+
+/**
+ * @brief Broadcast addressing for synchronized updates.
+ */
+#define DAC8571_BROADCAST_ADDRESS          0x48 ///< 7-bit broadcast address answered by every DAC8571 on the bus
+#define DAC8571_CMD_BROADCAST_UPDATE       DAC8571_CMD_BROADCAST_WRITE_TMP ///< Broadcast with PD0 clear: every device updates from its temporary register
+#ifndef DAC8571_GROUP_MAX_DEVICES
+#define DAC8571_GROUP_MAX_DEVICES          8 ///< Handles per synchronized group
+#endif
+
+
+#ifdef DAC8571_ENABLE_STATS
+#define DAC8571_STATS_BUCKETS       32 ///< log2 latency histogram buckets
+
+/**
+ * @brief Per-handle transaction statistics (DAC8571_ENABLE_STATS).
+ * @details Latencies are DWT cycles on target and nanoseconds on the host simulator.
  */
 typedef struct {
+    uint32_t transactions;   ///< Bus transactions (write, read, probe, DMA)
+    uint32_t errors;         ///< Transactions that did not return HAL_OK
+    uint32_t bytes;          ///< Payload bytes of successful transactions
+    uint32_t minCycles;      ///< Shortest transaction
+    uint32_t maxCycles;      ///< Longest transaction
+    uint32_t meanCycles;     ///< Mean transaction latency (filled by DAC8571_GetStats)
+    uint64_t totalCycles;    ///< Sum of all transaction latencies
+    uint32_t initCycles;     ///< Duration of the last DAC8571_Init probe sequence
+    uint32_t histogram[DAC8571_STATS_BUCKETS]; ///< Bucket i counts latencies in [2^i, 2^(i+1))
+} DAC8571_StatsTypeDef;
+#endif
+
+/**
+ * @brief Optional per-bus locking for RTOS builds (DAC8571_ENABLE_LOCKING).
+ * @details Every blocking call holds its bus's lock for the whole operation; sessions and
+ *          high-speed mode hold it until they end, DMA transfers until completion.
+ *
+ *          The lock is an atomic flag. Under an RTOS, also define the mutex hooks (typically in
+ *          DAC8571_CONFIG_FILE) so that tasks queue on one priority-inheriting mutex per bus
+ *          instead of spinning, e.g. for CMSIS-RTOS2:
+ *          @code
+ *          #include "cmsis_os2.h"
+ *          #define DAC8571_BUS_MUTEX_NEW()      osMutexNew(&(const osMutexAttr_t){ .attr_bits = osMutexPrioInherit })
+ *          #define DAC8571_BUS_LOCK(mutex, ms)  (osMutexAcquire((mutex), (ms)) == osOK)
+ *          #define DAC8571_BUS_UNLOCK(mutex)    osMutexRelease(mutex)
+ *          @endcode
+ *          DAC8571_BUS_MUTEX_NEW() runs when DAC8571_Init first sees a bus; DAC8571_BUS_LOCK returns
+ *          nonzero once the mutex is taken within ms milliseconds. The mutex is owned by the calling
+ *          task, so a session or high-speed mode must end in the task that began it. Interrupt
+ *          handlers and DMA completions only use the flag.
+ */
+#ifndef DAC8571_LOCK_TIMEOUT_MS
+#define DAC8571_LOCK_TIMEOUT_MS     100 ///< Longest wait for a bus held by another task (HAL_BUSY after)
+#endif
+#ifndef DAC8571_LOCK_YIELD
+#define DAC8571_LOCK_YIELD()        do { } while (0) ///< Run while the flag is held (by a DMA transfer or interrupt once the mutex hooks are set)
+#endif
+
+#ifdef DAC8571_ENABLE_LOCKING
+/**
+ * @brief Per-bus lock contention counters (DAC8571_ENABLE_LOCKING).
+ * @details Wait times are DWT cycles on target and nanoseconds on host builds.
+ */
+typedef struct {
+    uint32_t acquisitions;   ///< Locks taken
+    uint32_t contentions;    ///< Acquisitions that found the bus held and waited
+    uint32_t timeouts;       ///< Waits abandoned after DAC8571_LOCK_TIMEOUT_MS
+    uint32_t maxWaitCycles;  ///< Longest wait
+    uint64_t totalWaitCycles; ///< Sum of all waits
+} DAC8571_LockStatsTypeDef;
+#endif
+
+/**
+ * @brief Consistent copy of the mutable state of a handle (DAC8571_GetSnapshot).
+ */
+typedef struct {
+    uint16_t lastValue;      ///< Last written value
+    uint8_t writeMode;       ///< Current write mode
+    int lastError;           ///< Last error code (not cleared, unlike DAC8571_GetLastError)
+    uint8_t busy;            ///< Asynchronous transfer in flight
+    uint8_t cacheValid;      ///< Write cache holds the device state
+    uint8_t hsActive;        ///< High-speed session open
+    uint8_t initState;       ///< DAC8571_INIT_* detection state
+    uint8_t breakerState;    ///< DAC8571_BREAKER_* state
+    uint32_t suppressedWrites; ///< Writes skipped by the cache
+} DAC8571_SnapshotTypeDef;
+
+struct __DAC8571_HandleTypeDef;
+
+/**
+ * @brief Bus transport used by a DAC8571 handle.
+ * @details Each call receives the DAC8571 handle; a transport reaches its bus through
+ *          hdac8571->hi2c or hdac8571->transportContext. devAddress is the shifted 8-bit address.
+ *          All calls except TransmitAsync block until the transfer is complete. Asynchronous
+ *          completions are reported through DAC8571_I2C_MasterTxCpltHandler/ErrorHandler(hdac8571->hi2c).
+ */
+typedef struct {
+    HAL_StatusTypeDef (*Transmit)(struct __DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs); ///< Write, START to STOP
+    HAL_StatusTypeDef (*Receive)(struct __DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs);  ///< Read, START to STOP
+    HAL_StatusTypeDef (*Probe)(struct __DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint32_t timeoutMs);                                  ///< Address-only transaction
+    HAL_StatusTypeDef (*SeqTransmit)(struct __DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t options, uint32_t timeoutMs); ///< Sequential frame (I2C_*_FRAME options)
+    HAL_StatusTypeDef (*SeqStop)(struct __DAC8571_HandleTypeDef *hdac8571, uint32_t timeoutMs);                                                      ///< STOP that ends a sequence
+    HAL_StatusTypeDef (*TransmitAsync)(struct __DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size);                ///< Start a write (NULL: not supported)
+} DAC8571_TransportTypeDef;
+
+/**
+ * @brief Handle structure for the DAC8571 digital-to-analog converter.
+ */
+typedef struct __DAC8571_HandleTypeDef {
     I2C_HandleTypeDef *hi2c; ///< Pointer to the I2C handle
+    const DAC8571_TransportTypeDef *transport; ///< Bus transport (NULL at init selects DAC8571_HalTransport)
+    void *transportContext;  ///< Transport-specific bus state
     uint16_t address;         ///< I2C address of the DAC8571
     uint16_t lastValue;      ///< Last written value
     uint8_t writeMode;       ///< Current write mode
     int lastError;           ///< Last error code
+    uint8_t initState;       ///< DAC8571_INIT_* detection state
+    uint8_t initAttempts;    ///< Probe attempts made so far
+    uint32_t initNextTick;   ///< HAL tick of the next probe attempt
+    float refVoltage;        ///< Reference voltage (in volts)
+    uint32_t refMicrovolts;  ///< Reference voltage (in microvolts)
+    float codesPerVolt;      ///< Cached reciprocal 65535 / refVoltage
+    uint32_t codeScale;      ///< Codes per microvolt, fixed point with codeShift fractional bits
+    uint8_t codeShift;       ///< Fractional bits of codeScale (chosen to use all 32 bits)
+    uint8_t calEnabled;      ///< Apply calibration to voltage conversions
+    uint8_t calInlEnabled;   ///< Apply the INL table after gain/offset
+    int32_t calGain;         ///< Gain correction, Q16 (65536 = 1.0)
+    int32_t calOffset;       ///< Offset correction in LSB, Q16
+    int16_t calInl[DAC8571_CAL_INL_POINTS]; ///< Measured INL in LSB at every 2^DAC8571_CAL_INL_SHIFT codes
+
+    uint8_t cacheEnabled;    ///< Skip writes the device already holds (write-through cache)
+    uint8_t cacheValid;      ///< lastValue/cachedMode reflect the device state
+    uint8_t cachedMode;      ///< Control byte of the last successful write
+    uint32_t suppressedWrites; ///< Writes skipped by the cache
+
+    uint32_t busClockHz;     ///< SCL frequency used to derive timeouts
+    uint8_t timeoutSlack;    ///< Timeout multiple of the nominal transaction time
+    uint8_t hsActive;        ///< High-speed session open (see DAC8571_HS_Begin)
+    uint32_t hsSavedClockHz; ///< F/S-mode ClockSpeed restored by DAC8571_HS_End
+    uint8_t hsLockHeld;      ///< The high-speed session holds the bus lock
+    uint8_t breakerState;    ///< DAC8571_BREAKER_* state
+    uint8_t consecutiveErrors; ///< Failed transactions since the last success
+    uint32_t breakerOpenedTick; ///< HAL tick at which the breaker last opened
+    uint32_t breakerTrips;   ///< Times the breaker has opened
+    uint32_t busRecoveries;  ///< Bus recovery sequences performed
+    volatile uint8_t recoveryPending; ///< An asynchronous transfer timed out; recover before the next blocking transfer
+    GPIO_TypeDef *sclPort;   ///< SCL port for bus recovery (NULL: recovery disabled)
+    GPIO_TypeDef *sdaPort;   ///< SDA port for bus recovery
+    uint16_t sclPin;         ///< SCL pin mask
+    uint16_t sdaPin;         ///< SDA pin mask
+
+    volatile uint8_t busy;   ///< Asynchronous transfer in flight
+    uint16_t pendingValue;   ///< Value that becomes lastValue when the transfer completes
+    uint16_t pendingSize;    ///< Bytes in the transfer in flight
+    uint8_t pendingMode;     ///< Control byte of the transfer in flight
+    uint8_t txBuffer[1 + 2 * DAC8571_ASYNC_MAX_SAMPLES]; ///< DMA transmit buffer
+    void (*TxCpltCallback)(struct __DAC8571_HandleTypeDef *hdac8571); ///< Asynchronous transfer complete callback
+    void (*ErrorCallback)(struct __DAC8571_HandleTypeDef *hdac8571);  ///< Asynchronous transfer error callback
+
+#ifdef DAC8571_ENABLE_STATS
+    DAC8571_StatsTypeDef stats; ///< Transaction statistics
+    uint32_t asyncStart;        ///< Start timestamp of the transfer in flight
+#endif
 } DAC8571_HandleTypeDef;
 
+/**
+ * @brief Group of DAC8571 devices on one I2C bus updated on the same bus edge.
+ */
+typedef struct {
+    DAC8571_HandleTypeDef *members[DAC8571_GROUP_MAX_DEVICES]; ///< Member handles
+    uint16_t pending[DAC8571_GROUP_MAX_DEVICES];               ///< Values loaded into the temporary registers
+    uint8_t count;                                             ///< Number of members
+} DAC8571_GroupTypeDef;
+
+/**
+ * @brief Bus held across back-to-back writes: frames are joined by repeated STARTs, one STOP at the end.
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c; ///< Bus owned by the session
+    DAC8571_HandleTypeDef *last; ///< Handle of the latest frame (its transport sends the STOP)
+    uint8_t open;            ///< Session started and not ended by DAC8571_Session_End or an error
+    uint8_t locked;          ///< The session holds the bus lock (DAC8571_ENABLE_LOCKING)
+    uint32_t frames;         ///< Frames sent since DAC8571_Session_Begin (0: next frame sends START)
+} DAC8571_SessionTypeDef;
+
+/**
+ * @brief Asynchronous transfer callback type.
+ */
+typedef void (*DAC8571_CallbackTypeDef)(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Default transport: STM32 HAL I2C (blocking, sequential IT and DMA calls on hdac8571->hi2c).
+ */
+extern const DAC8571_TransportTypeDef DAC8571_HalTransport;
+HAL_StatusTypeDef DAC8571_Hal_Transmit(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_Hal_Receive(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_Hal_Probe(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_Hal_SeqTransmit(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t options, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_Hal_SeqStop(DAC8571_HandleTypeDef *hdac8571, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_Hal_TransmitAsync(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size);
+
+/**
+ * @brief Compile-time transport binding.
+ * @details Define DAC8571_STATIC_TRANSPORT to a function-name prefix (e.g. -DDAC8571_STATIC_TRANSPORT=DAC8571_Hal)
+ *          and the driver calls <prefix>_Transmit, <prefix>_Receive, ... directly instead of through
+ *          hdac8571->transport, so the compiler can inline them. All six functions must exist.
+ */
+#ifdef DAC8571_STATIC_TRANSPORT
+#define DAC8571_PASTE_(a, b) a##_##b
+#define DAC8571_PASTE(a, b)  DAC8571_PASTE_(a, b)
+HAL_StatusTypeDef DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, Transmit)(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, Receive)(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, Probe)(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, SeqTransmit)(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size, uint32_t options, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, SeqStop)(DAC8571_HandleTypeDef *hdac8571, uint32_t timeoutMs);
+HAL_StatusTypeDef DAC8571_PASTE(DAC8571_STATIC_TRANSPORT, TransmitAsync)(DAC8571_HandleTypeDef *hdac8571, uint16_t devAddress, uint8_t *data, uint16_t size);
+#endif
+
 /**
  * @brief Initialize the DAC8571 handle.
  * @param hdac8571 Pointer to the DAC8571 handle structure.
@@ -71,6 +372,60 @@ typedef struct {
  */
 void DAC8571_Init(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address);
 
+/**
+ * @brief Initialize the DAC8571 handle with a board-specific reference voltage.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param hi2c Pointer to the I2C handle.
+ * @param address I2C address of the DAC8571.
+ * @param refVoltage Reference voltage in volts (DAC8571_REF_VOLTAGE_MIN to DAC8571_REF_VOLTAGE_MAX).
+ */
+void DAC8571_InitWithReference(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address, float refVoltage);
+
+/**
+ * @brief Start non-blocking initialization of the DAC8571 handle.
+ * @details Sets up the handle like DAC8571_Init but does not probe; call DAC8571_InitPoll
+ *          (or DAC8571_InitPollAll) periodically until the state is READY or ABSENT.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param hi2c Pointer to the I2C handle.
+ * @param address I2C address of the DAC8571.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_InitAsync(DAC8571_HandleTypeDef *hdac8571, I2C_HandleTypeDef *hi2c, uint8_t address);
+
+/**
+ * @brief Advance non-blocking initialization; makes at most one short probe and never delays.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return Current DAC8571_INIT_* state.
+ */
+uint8_t DAC8571_InitPoll(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Advance non-blocking initialization of several devices, on one or several buses.
+ * @param handles Array of DAC8571 handle pointers.
+ * @param count Number of handles.
+ * @return Number of devices still probing.
+ */
+uint8_t DAC8571_InitPollAll(DAC8571_HandleTypeDef **handles, uint8_t count);
+
+/**
+ * @brief Get the detection state of the DAC8571.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return DAC8571_INIT_IDLE, DAC8571_INIT_PROBING, DAC8571_INIT_READY or DAC8571_INIT_ABSENT.
+ */
+uint8_t DAC8571_GetInitState(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Select the bus transport of a handle.
+ * @details Call on a zero-initialized handle before DAC8571_Init so the probe uses it, or at any
+ *          time when no transfer is in flight. hi2c still identifies the bus (asynchronous
+ *          completions are matched by it). Ignored when DAC8571_STATIC_TRANSPORT is defined.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param transport Transport (NULL selects DAC8571_HalTransport).
+ * @param context Transport-specific bus state, stored in hdac8571->transportContext.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetTransport(DAC8571_HandleTypeDef *hdac8571, const DAC8571_TransportTypeDef *transport, void *context);
+
 /**
  * @brief Write a value to the DAC8571.
  * @param hdac8571 Pointer to the DAC8571 handle structure.
@@ -88,6 +443,98 @@ HAL_StatusTypeDef DAC8571_Write(DAC8571_HandleTypeDef *hdac8571, uint16_t value)
  */
 HAL_StatusTypeDef DAC8571_WriteArray(DAC8571_HandleTypeDef *hdac8571, uint16_t *arr, uint8_t length);
 
+/**
+ * @brief Stream an array of values to the DAC8571 using burst transactions.
+ * @details The control byte is sent once, followed by back-to-back MSB/LSB pairs;
+ *          the DAC output updates after every pair. Arrays longer than
+ *          DAC8571_STREAM_MAX_SAMPLES are sent as consecutive bursts.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param arr Pointer to the array of 16-bit values to write.
+ * @param length Number of values in the array.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_WriteStream(DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length);
+
+/**
+ * @brief Start an asynchronous (DMA) write of a value to the DAC8571.
+ * @details Returns immediately; completion is reported through the TxCplt/Error callbacks.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param value 16-bit value to write.
+ * @return HAL_OK if the transfer was started, HAL_BUSY if one is already in flight.
+ */
+HAL_StatusTypeDef DAC8571_WriteAsync(DAC8571_HandleTypeDef *hdac8571, uint16_t value);
+
+/**
+ * @brief Start an asynchronous (DMA) burst write of an array of values to the DAC8571.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param arr Pointer to the array of 16-bit values to write (copied before returning).
+ * @param length Number of values in the array (up to DAC8571_ASYNC_MAX_SAMPLES).
+ * @return HAL_OK if the transfer was started, HAL_BUSY if one is already in flight.
+ */
+HAL_StatusTypeDef DAC8571_WriteArrayAsync(DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length);
+
+/**
+ * @brief Encode samples once into a bus-ready frame buffer for repeated playback.
+ * @details Layout is the control byte (current write mode) followed by MSB/LSB pairs, exactly as
+ *          sent on the bus, so DAC8571_WriteFrames/DAC8571_WriteFramesAsync replay it with no
+ *          per-sample work.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param arr Pointer to the array of 16-bit values to encode.
+ * @param length Number of values (up to DAC8571_FRAME_MAX_SAMPLES).
+ * @param frame Destination buffer.
+ * @param frameSize Size of frame in bytes (at least DAC8571_FRAME_SIZE(length)).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_EncodeFrames(DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length, uint8_t *frame, uint32_t frameSize);
+
+/**
+ * @brief Send a frame buffer built by DAC8571_EncodeFrames in a single transaction.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param frame Encoded frame buffer.
+ * @param size Bytes to send (DAC8571_FRAME_SIZE of the sample count).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_WriteFrames(DAC8571_HandleTypeDef *hdac8571, const uint8_t *frame, uint16_t size);
+
+/**
+ * @brief Start an asynchronous (DMA) transfer straight from a frame buffer, without copying it.
+ * @details The buffer must stay valid and unchanged until the TxCplt/Error callback.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param frame Encoded frame buffer.
+ * @param size Bytes to send (DAC8571_FRAME_SIZE of the sample count).
+ * @return HAL_OK if the transfer was started, HAL_BUSY if one is already in flight.
+ */
+HAL_StatusTypeDef DAC8571_WriteFramesAsync(DAC8571_HandleTypeDef *hdac8571, const uint8_t *frame, uint16_t size);
+
+/**
+ * @brief Check whether an asynchronous transfer is in flight.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return 1 if busy, 0 otherwise.
+ */
+uint8_t DAC8571_IsBusy(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Register the asynchronous transfer callbacks.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param txCplt Called from interrupt context when a transfer completes (may be NULL).
+ * @param error Called from interrupt context when a transfer fails (may be NULL).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_RegisterCallbacks(DAC8571_HandleTypeDef *hdac8571, DAC8571_CallbackTypeDef txCplt, DAC8571_CallbackTypeDef error);
+
+/**
+ * @brief Forward HAL_I2C_MasterTxCpltCallback to the driver.
+ * @details Not needed when DAC8571_USE_HAL_I2C_CALLBACKS is defined (the driver then defines the HAL hooks).
+ * @param hi2c Pointer to the I2C handle that completed.
+ */
+void DAC8571_I2C_MasterTxCpltHandler(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Forward HAL_I2C_ErrorCallback to the driver.
+ * @param hi2c Pointer to the I2C handle that failed.
+ */
+void DAC8571_I2C_ErrorHandler(I2C_HandleTypeDef *hi2c);
+
 /**
  * @brief Read the last written value from the DAC8571 handle.
  * @param hdac8571 Pointer to the DAC8571 handle structure.
@@ -105,11 +552,107 @@ HAL_StatusTypeDef DAC8571_IsConnected(DAC8571_HandleTypeDef *hdac8571);
 /**
  * @brief Set the DAC output value in volts.
  * @param hdac8571 Pointer to the DAC8571 handle structure.
- * @param voltage Output voltage to set (0 to DAC8571_REF_VOLTAGE).
+ * @param voltage Output voltage to set (0 to the handle's reference voltage).
  * @return HAL status of the operation.
  */
 HAL_StatusTypeDef DAC8571_SetVoltage(DAC8571_HandleTypeDef *hdac8571, float voltage);
 
+/**
+ * @brief Set the reference voltage of the DAC8571 and recompute the conversion factors.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param refVoltage Reference voltage in volts (DAC8571_REF_VOLTAGE_MIN to DAC8571_REF_VOLTAGE_MAX).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetReference(DAC8571_HandleTypeDef *hdac8571, float refVoltage);
+
+/**
+ * @brief Get the reference voltage of the DAC8571.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return Reference voltage in volts.
+ */
+float DAC8571_GetReference(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Set the DAC output value in millivolts (integer conversion, rounded to nearest code).
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param millivolts Output voltage to set (0 to the reference voltage).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetMillivolts(DAC8571_HandleTypeDef *hdac8571, uint32_t millivolts);
+
+/**
+ * @brief Set the DAC output value in microvolts (integer conversion, rounded to nearest code).
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param microvolts Output voltage to set (0 to the reference voltage).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetMicrovolts(DAC8571_HandleTypeDef *hdac8571, uint32_t microvolts);
+
+/**
+ * @brief Set the gain and offset correction applied to every voltage-to-code conversion.
+ * @details The corrected code is code * gain + offset, computed in Q16 fixed point and clamped.
+ *          Applies to DAC8571_SetVoltage, DAC8571_SetMillivolts, DAC8571_SetMicrovolts and the
+ *          batch conversions; raw code writes (DAC8571_Write, arrays, streams) are sent as given.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param gain Gain correction (DAC8571_CAL_GAIN_MIN to DAC8571_CAL_GAIN_MAX, 1.0 = none).
+ * @param offsetLsb Offset correction in LSB (fractions allowed).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetCalibration(DAC8571_HandleTypeDef *hdac8571, float gain, float offsetLsb);
+
+/**
+ * @brief Set a piecewise-linear INL correction table, applied after gain and offset.
+ * @details Entry i is the measured INL in LSB at code i << DAC8571_CAL_INL_SHIFT (the last entry
+ *          extrapolates to full scale); it is interpolated linearly and subtracted from the code.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param table DAC8571_CAL_INL_POINTS entries (copied), or NULL to disable INL correction.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetInlTable(DAC8571_HandleTypeDef *hdac8571, const int16_t *table);
+
+/**
+ * @brief Remove gain, offset and INL correction.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_ClearCalibration(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Apply the handle's calibration to a block of codes in place.
+ * @details For codes computed by the application before DAC8571_WriteArray or DAC8571_WriteStream.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param codes Codes to correct.
+ * @param length Number of codes.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_CalibrateCodes(DAC8571_HandleTypeDef *hdac8571, uint16_t *codes, uint32_t length);
+
+/**
+ * @brief Convert a block of voltages to DAC codes with the handle's reference.
+ * @details Same rounding as DAC8571_SetVoltage, but out-of-range inputs are clamped (below 0 V and
+ *          NaN give 0x0000, above the reference 0xFFFF) instead of rejected, then calibrated. Uses SSE2
+ *          or NEON on host builds and packed halfword stores on Cortex-M4; results are identical on
+ *          every path.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param volts Input voltages.
+ * @param codes Output codes in native byte order (for DAC8571_WriteStream and friends).
+ * @param length Number of values.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_VoltsToCodes(DAC8571_HandleTypeDef *hdac8571, const float *volts, uint16_t *codes, uint32_t length);
+
+/**
+ * @brief Convert a block of voltages straight into a frame buffer in wire (big-endian) order.
+ * @details Conversion as DAC8571_VoltsToCodes; the layout is that of DAC8571_EncodeFrames.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param volts Input voltages.
+ * @param length Number of values (up to DAC8571_FRAME_MAX_SAMPLES).
+ * @param frame Destination buffer.
+ * @param frameSize Size of frame in bytes (at least DAC8571_FRAME_SIZE(length)).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_VoltsToFrames(DAC8571_HandleTypeDef *hdac8571, const float *volts, uint16_t length, uint8_t *frame, uint32_t frameSize);
+
 /**
  * @brief Set the write mode for the DAC8571.
  * @param hdac8571 Pointer to the DAC8571 handle structure.
@@ -147,6 +690,218 @@ HAL_StatusTypeDef DAC8571_WakeUp(DAC8571_HandleTypeDef *hdac8571, uint16_t value
  */
 HAL_StatusTypeDef DAC8571_Reset(DAC8571_HandleTypeDef *hdac8571);
 
+/**
+ * @brief Initialize an empty synchronized group.
+ * @param group Pointer to the group structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Group_Init(DAC8571_GroupTypeDef *group);
+
+/**
+ * @brief Add an initialized handle to a group; all members must share one I2C bus.
+ * @param group Pointer to the group structure.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Group_Add(DAC8571_GroupTypeDef *group, DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Load each member's temporary register without changing the outputs.
+ * @param group Pointer to the group structure.
+ * @param values One value per member, in the order they were added.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Group_Load(DAC8571_GroupTypeDef *group, const uint16_t *values);
+
+/**
+ * @brief Latch all temporary registers with a single broadcast transaction.
+ * @note Every DAC8571 on the bus answers the broadcast address, including devices outside the group.
+ * @param group Pointer to the group structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Group_Update(DAC8571_GroupTypeDef *group);
+
+/**
+ * @brief Load all members and latch them together (DAC8571_Group_Load + DAC8571_Group_Update).
+ * @param group Pointer to the group structure.
+ * @param values One value per member, in the order they were added.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Group_Write(DAC8571_GroupTypeDef *group, const uint16_t *values);
+
+/**
+ * @brief Start a repeated-START session on a bus.
+ * @details Frames written through the session (to any DAC8571 on that bus) are sent with
+ *          HAL_I2C_Master_Seq_Transmit_IT: the first with a START, the rest with a repeated
+ *          START, and no STOP until DAC8571_Session_End. A NACK or timeout ends the session.
+ * @param session Pointer to the session structure.
+ * @param hi2c Pointer to the I2C handle.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Session_Begin(DAC8571_SessionTypeDef *session, I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Write a value to a DAC8571 within a session.
+ * @param session Pointer to the session structure.
+ * @param hdac8571 Pointer to the DAC8571 handle structure (on the session's bus).
+ * @param value 16-bit value to write.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Session_Write(DAC8571_SessionTypeDef *session, DAC8571_HandleTypeDef *hdac8571, uint16_t value);
+
+/**
+ * @brief Stream samples to a DAC8571 within a session (DAC8571_STREAM_MAX_SAMPLES per frame).
+ * @param session Pointer to the session structure.
+ * @param hdac8571 Pointer to the DAC8571 handle structure (on the session's bus).
+ * @param arr Pointer to the array of values.
+ * @param length Number of values.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Session_WriteStream(DAC8571_SessionTypeDef *session, DAC8571_HandleTypeDef *hdac8571, const uint16_t *arr, uint16_t length);
+
+/**
+ * @brief End a session: send the STOP that releases the bus.
+ * @param session Pointer to the session structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Session_End(DAC8571_SessionTypeDef *session);
+
+/**
+ * @brief Enable or disable the write-through cache.
+ * @details When enabled, DAC8571_Write returns HAL_OK without bus traffic if the value and
+ *          control byte match the last successful write. The cache is invalidated by errors,
+ *          power-down, wake-up, reset and asynchronous or group transfers.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param enable 1 to enable, 0 to disable.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetCacheMode(DAC8571_HandleTypeDef *hdac8571, uint8_t enable);
+
+/**
+ * @brief Force the next write to reach the device (e.g. after an external reset).
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_InvalidateCache(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Get the number of writes suppressed by the cache.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return Suppressed write count.
+ */
+uint32_t DAC8571_GetSuppressedWrites(DAC8571_HandleTypeDef *hdac8571);
+
+#ifdef DAC8571_ENABLE_STATS
+/**
+ * @brief Copy the transaction statistics of the DAC8571 handle.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param stats Destination for the statistics (meanCycles is computed).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_GetStats(DAC8571_HandleTypeDef *hdac8571, DAC8571_StatsTypeDef *stats);
+
+/**
+ * @brief Clear the transaction statistics of the DAC8571 handle.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_ResetStats(DAC8571_HandleTypeDef *hdac8571);
+#endif
+
+/**
+ * @brief Copy the handle's mutable state in one step, consistent with concurrent writes.
+ * @details With DAC8571_ENABLE_LOCKING the copy is taken under the bus lock, so it may wait for
+ *          (or, after DAC8571_LOCK_TIMEOUT_MS, give up on) a transfer in progress.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param snapshot Destination for the state.
+ * @return HAL status of the operation (HAL_BUSY if the bus lock could not be taken).
+ */
+HAL_StatusTypeDef DAC8571_GetSnapshot(DAC8571_HandleTypeDef *hdac8571, DAC8571_SnapshotTypeDef *snapshot);
+
+#ifdef DAC8571_ENABLE_LOCKING
+/**
+ * @brief Copy the lock contention counters of an I2C bus.
+ * @param hi2c Bus used by one or more initialized DAC8571 handles.
+ * @param stats Destination for the counters.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_GetLockStats(I2C_HandleTypeDef *hi2c, DAC8571_LockStatsTypeDef *stats);
+#endif
+
+/**
+ * @brief Open a high-speed mode session.
+ * @details Sends the master code at the configured F/S clock, re-initializes the I2C peripheral at
+ *          hsClockHz and keeps the bus: until DAC8571_HS_End, blocking writes (DAC8571_Write,
+ *          DAC8571_WriteStream, ...) are sent as repeated-START frames without a STOP.
+ *          Requires DAC8571_ENABLE_HS; fails with HAL_ERROR without it, or if the HAL answers the
+ *          master-code NACK with a STOP.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param hsClockHz HS-mode SCL frequency (up to DAC8571_HS_MAX_CLOCK_HZ).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_HS_Begin(DAC8571_HandleTypeDef *hdac8571, uint32_t hsClockHz);
+
+/**
+ * @brief Close the high-speed mode session: send STOP and restore the F/S clock.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_HS_End(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Set the bus clock and slack factor used to derive transfer timeouts.
+ * @details DAC8571_Init takes the clock from hi2c->Init.ClockSpeed; call this on parts whose
+ *          I2C init structure has no ClockSpeed field, or after changing the bus speed.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param busClockHz SCL frequency in Hz.
+ * @param slack Timeout as a multiple of the nominal transaction time.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetBusTiming(DAC8571_HandleTypeDef *hdac8571, uint32_t busClockHz, uint8_t slack);
+
+/**
+ * @brief Get the timeout applied to a blocking transfer.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param bytes Payload bytes after the address byte.
+ * @return Timeout in milliseconds.
+ */
+uint32_t DAC8571_GetTimeout(DAC8571_HandleTypeDef *hdac8571, uint16_t bytes);
+
+/**
+ * @brief Get the circuit breaker state.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return DAC8571_BREAKER_CLOSED, DAC8571_BREAKER_OPEN or DAC8571_BREAKER_HALF_OPEN.
+ */
+uint8_t DAC8571_GetBreakerState(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Close the circuit breaker and clear the consecutive error count.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_ResetBreaker(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Set the GPIO pins used for I2C bus recovery.
+ * @details With pins set, a blocking transfer that times out triggers DAC8571_BusRecover automatically.
+ *          A timeout reported from the I2C interrupt only marks the bus; recovery then runs at the
+ *          start of the next blocking transfer or an explicit DAC8571_BusRecover, never in the interrupt.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param sclPort GPIO port of SCL (NULL disables recovery).
+ * @param sclPin GPIO pin mask of SCL.
+ * @param sdaPort GPIO port of SDA.
+ * @param sdaPin GPIO pin mask of SDA.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_SetRecoveryPins(DAC8571_HandleTypeDef *hdac8571, GPIO_TypeDef *sclPort, uint16_t sclPin, GPIO_TypeDef *sdaPort, uint16_t sdaPin);
+
+/**
+ * @brief Free a stuck I2C bus: clock SCL until the slave releases SDA, send STOP and re-initialize the peripheral.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return HAL_OK if SDA was released, HAL_ERROR otherwise.
+ */
+HAL_StatusTypeDef DAC8571_BusRecover(DAC8571_HandleTypeDef *hdac8571);
+
 /**
  * @brief Get the last error code from the DAC8571 operations.
  * @param hdac8571 Pointer to the DAC8571 handle structure.
@@ -167,6 +922,14 @@ uint8_t DAC8571_GetAddress(DAC8571_HandleTypeDef *hdac8571);
  */
 void DAC8571_SelfTest(DAC8571_HandleTypeDef *hdac8571);
 
+/**
+ * @brief Measures write throughput (samples per second) of the single-sample and streaming paths,
+ *        and the cost of voltage-to-code conversion (DWT cycles on target, nanoseconds on host).
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param samples Number of samples to write with each method.
+ */
+void DAC8571_Benchmark(DAC8571_HandleTypeDef *hdac8571, uint32_t samples);
+
 const char* HAL_StatusToString(HAL_StatusTypeDef status);
 
 #ifdef __cplusplus
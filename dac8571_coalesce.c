@@ -0,0 +1,193 @@
+/*
+ * @file    dac8571_coalesce.c
+ * @author  lekhnitsky
+ * @brief   Last-write-wins update coalescing across many DAC8571 channels.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_coalesce.h"
+#include <stddef.h>
+
+static void DAC8571_Coalesce_Set(DAC8571_CoalesceTypeDef *coalesce, DAC8571_CoalesceEntryTypeDef *entry, uint16_t value) {
+    uint32_t old = __atomic_exchange_n(&entry->pending, value | DAC8571_COALESCE_PENDING, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&coalesce->stats.submitted, 1, __ATOMIC_RELAXED);
+    if (old & DAC8571_COALESCE_PENDING) {
+        __atomic_fetch_add(&coalesce->stats.dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Write the pending values of one sweep over the channels, starting at the cursor.
+ * @param level Only channels with this priority, or -1 for all.
+ * @param budget Remaining bus writes (NULL = no limit).
+ * @return HAL_OK, or the status of the first failed write.
+ */
+static HAL_StatusTypeDef DAC8571_Coalesce_Sweep(DAC8571_CoalesceTypeDef *coalesce, int level, uint16_t *budget) {
+    HAL_StatusTypeDef result = HAL_OK;
+    uint16_t start = coalesce->cursor;
+
+    for (uint16_t k = 0; k < coalesce->count; k++) {
+        uint16_t i = (uint16_t)((start + k) % coalesce->count);
+        DAC8571_CoalesceEntryTypeDef *entry = &coalesce->entries[i];
+        if (level >= 0 && entry->priority != level) {
+            continue;
+        }
+        if (budget && *budget == 0) {
+            break;
+        }
+
+        uint32_t pending = __atomic_exchange_n(&entry->pending, 0, __ATOMIC_ACQUIRE);
+        if (!(pending & DAC8571_COALESCE_PENDING)) {
+            continue;
+        }
+
+        // lastValue is only trusted while the cache state says the device still holds it
+        DAC8571_HandleTypeDef *hdac8571 = entry->hdac8571;
+        uint16_t value = (uint16_t)pending;
+        if (hdac8571->cacheValid && hdac8571->lastValue == value && hdac8571->cachedMode == hdac8571->writeMode) {
+            coalesce->stats.unchanged++;
+            continue;
+        }
+
+        HAL_StatusTypeDef status = DAC8571_Write(hdac8571, value);
+        coalesce->cursor = (uint16_t)((i + 1) % coalesce->count);
+        if (budget) {
+            (*budget)--;
+        }
+        if (status != HAL_OK) {
+            // Retry next call unless a newer value has been submitted meanwhile
+            uint32_t expected = 0;
+            __atomic_compare_exchange_n(&entry->pending, &expected, pending, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            coalesce->stats.failed++;
+            if (result == HAL_OK) {
+                result = status;
+            }
+            continue;
+        }
+        coalesce->stats.written++;
+    }
+    return result;
+}
+
+HAL_StatusTypeDef DAC8571_Coalesce_Init(DAC8571_CoalesceTypeDef *coalesce, DAC8571_CoalesceEntryTypeDef *entries,
+                                        uint16_t capacity, uint8_t policy) {
+    if (!coalesce || !entries || capacity == 0 || policy > DAC8571_COALESCE_PRIORITY) {
+        return HAL_ERROR;
+    }
+
+    coalesce->entries = entries;
+    coalesce->capacity = capacity;
+    coalesce->count = 0;
+    coalesce->cursor = 0;
+    coalesce->policy = policy;
+    coalesce->stats = (DAC8571_CoalesceStatsTypeDef){0};
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Coalesce_Add(DAC8571_CoalesceTypeDef *coalesce, DAC8571_HandleTypeDef *hdac8571, uint8_t priority) {
+    if (!coalesce || !hdac8571 || coalesce->count >= coalesce->capacity) {
+        return HAL_ERROR;
+    }
+    for (uint16_t i = 0; i < coalesce->count; i++) {
+        if (coalesce->entries[i].hdac8571 == hdac8571) {
+            return HAL_ERROR;
+        }
+    }
+
+    DAC8571_CoalesceEntryTypeDef *entry = &coalesce->entries[coalesce->count];
+    entry->hdac8571 = hdac8571;
+    entry->pending = 0;
+    entry->priority = priority;
+    coalesce->count++;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Coalesce_Submit(DAC8571_CoalesceTypeDef *coalesce, DAC8571_HandleTypeDef *hdac8571, uint16_t value) {
+    if (!coalesce || !hdac8571) {
+        return HAL_ERROR;
+    }
+
+    for (uint16_t i = 0; i < coalesce->count; i++) {
+        if (coalesce->entries[i].hdac8571 == hdac8571) {
+            DAC8571_Coalesce_Set(coalesce, &coalesce->entries[i], value);
+            return HAL_OK;
+        }
+    }
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef DAC8571_Coalesce_SubmitTable(DAC8571_CoalesceTypeDef *coalesce, const uint16_t *values) {
+    if (!coalesce || !values) {
+        return HAL_ERROR;
+    }
+
+    for (uint16_t i = 0; i < coalesce->count; i++) {
+        DAC8571_Coalesce_Set(coalesce, &coalesce->entries[i], values[i]);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Coalesce_Process(DAC8571_CoalesceTypeDef *coalesce, uint16_t maxWrites) {
+    if (!coalesce || !coalesce->entries) {
+        return HAL_ERROR;
+    }
+    if (coalesce->count == 0) {
+        return HAL_OK;
+    }
+
+    uint16_t budget = maxWrites;
+    uint16_t *limit = (maxWrites != 0) ? &budget : NULL;
+    if (coalesce->policy == DAC8571_COALESCE_ROUND_ROBIN) {
+        return DAC8571_Coalesce_Sweep(coalesce, -1, limit);
+    }
+
+    // One sweep per priority level present, highest first
+    HAL_StatusTypeDef result = HAL_OK;
+    int level = 256;
+    while (!limit || budget > 0) {
+        int next = -1;
+        for (uint16_t i = 0; i < coalesce->count; i++) {
+            int priority = coalesce->entries[i].priority;
+            if (priority < level && priority > next) {
+                next = priority;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        level = next;
+
+        HAL_StatusTypeDef status = DAC8571_Coalesce_Sweep(coalesce, level, limit);
+        if (status != HAL_OK && result == HAL_OK) {
+            result = status;
+        }
+    }
+    return result;
+}
+
+uint16_t DAC8571_Coalesce_GetPending(DAC8571_CoalesceTypeDef *coalesce) {
+    if (!coalesce) {
+        return 0;
+    }
+
+    uint16_t pending = 0;
+    for (uint16_t i = 0; i < coalesce->count; i++) {
+        if (__atomic_load_n(&coalesce->entries[i].pending, __ATOMIC_RELAXED) & DAC8571_COALESCE_PENDING) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+HAL_StatusTypeDef DAC8571_Coalesce_GetStats(DAC8571_CoalesceTypeDef *coalesce, DAC8571_CoalesceStatsTypeDef *stats) {
+    if (!coalesce || !stats) {
+        return HAL_ERROR;
+    }
+
+    stats->submitted = __atomic_load_n(&coalesce->stats.submitted, __ATOMIC_RELAXED);
+    stats->written = coalesce->stats.written;
+    stats->dropped = __atomic_load_n(&coalesce->stats.dropped, __ATOMIC_RELAXED);
+    stats->unchanged = coalesce->stats.unchanged;
+    stats->failed = coalesce->stats.failed;
+    return HAL_OK;
+}
@@ -0,0 +1,127 @@
+/*
+ * @file    dac8571_coalesce.h
+ * @author  lekhnitsky
+ * @brief   Last-write-wins update coalescing across many DAC8571 channels.
+ * @date    2025-01-17
+ */
+
+#ifndef INC_DAC8571_COALESCE_H_
+#define INC_DAC8571_COALESCE_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dac8571.h"
+
+/**
+ * @brief Drain orders.
+ */
+#define DAC8571_COALESCE_ROUND_ROBIN 0x00 ///< Channels take turns, starting after the last one written
+#define DAC8571_COALESCE_PRIORITY    0x01 ///< Higher priority first, round-robin within a priority
+
+#define DAC8571_COALESCE_PENDING     0x10000UL ///< Marks DAC8571_CoalesceEntryTypeDef::pending as holding a value
+
+/**
+ * @brief One channel: the newest value not yet written to its device.
+ */
+typedef struct {
+    DAC8571_HandleTypeDef *hdac8571; ///< Device the value is written to
+    volatile uint32_t pending;       ///< Newest value | DAC8571_COALESCE_PENDING, 0 when nothing is pending
+    uint8_t priority;                ///< Drain priority (higher first) for DAC8571_COALESCE_PRIORITY
+} DAC8571_CoalesceEntryTypeDef;
+
+/**
+ * @brief Coalescing counters.
+ */
+typedef struct {
+    uint32_t submitted;  ///< Values submitted
+    uint32_t written;    ///< Values written to a device
+    uint32_t dropped;    ///< Stale values replaced by a newer one before they were written
+    uint32_t unchanged;  ///< Values skipped because the device already held them (lastValue)
+    uint32_t failed;     ///< Writes that failed (the value stays pending unless replaced)
+} DAC8571_CoalesceStatsTypeDef;
+
+/**
+ * @brief Coalescing scheduler: one pending slot per channel, so only the newest value is sent.
+ * @details Submissions are lock-free and may come from interrupt context; DAC8571_Coalesce_Process
+ *          must be called from a single task.
+ */
+typedef struct {
+    DAC8571_CoalesceEntryTypeDef *entries; ///< Channel storage (capacity entries)
+    uint16_t capacity;                     ///< Size of entries
+    uint16_t count;                        ///< Channels added
+    uint16_t cursor;                       ///< Channel the next round-robin sweep starts at
+    uint8_t policy;                        ///< DAC8571_COALESCE_ROUND_ROBIN or DAC8571_COALESCE_PRIORITY
+    DAC8571_CoalesceStatsTypeDef stats;    ///< Counters
+} DAC8571_CoalesceTypeDef;
+
+/**
+ * @brief Initialize a coalescing scheduler.
+ * @param coalesce Pointer to the scheduler structure.
+ * @param entries Channel storage.
+ * @param capacity Number of entries.
+ * @param policy DAC8571_COALESCE_ROUND_ROBIN or DAC8571_COALESCE_PRIORITY.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Coalesce_Init(DAC8571_CoalesceTypeDef *coalesce, DAC8571_CoalesceEntryTypeDef *entries,
+                                        uint16_t capacity, uint8_t policy);
+
+/**
+ * @brief Add a channel; channels are numbered in the order they are added.
+ * @param coalesce Pointer to the scheduler structure.
+ * @param hdac8571 Pointer to an initialized DAC8571 handle (at most once per scheduler).
+ * @param priority Drain priority, higher first (ignored for DAC8571_COALESCE_ROUND_ROBIN).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Coalesce_Add(DAC8571_CoalesceTypeDef *coalesce, DAC8571_HandleTypeDef *hdac8571, uint8_t priority);
+
+/**
+ * @brief Set the newest value for a channel, replacing any value still pending.
+ * @param coalesce Pointer to the scheduler structure.
+ * @param hdac8571 Channel handle, as passed to DAC8571_Coalesce_Add.
+ * @param value 16-bit DAC code.
+ * @return HAL_OK, or HAL_ERROR if the handle was not added.
+ */
+HAL_StatusTypeDef DAC8571_Coalesce_Submit(DAC8571_CoalesceTypeDef *coalesce, DAC8571_HandleTypeDef *hdac8571, uint16_t value);
+
+/**
+ * @brief Set the newest value for every channel from a setpoint table.
+ * @param coalesce Pointer to the scheduler structure.
+ * @param values One code per channel, in the order the channels were added.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Coalesce_SubmitTable(DAC8571_CoalesceTypeDef *coalesce, const uint16_t *values);
+
+/**
+ * @brief Write pending values, each channel at most once per call.
+ * @details A value the device already holds (matching lastValue and write mode) is not sent.
+ *          A failed write leaves its value pending for the next call; the other channels are still served.
+ * @param coalesce Pointer to the scheduler structure.
+ * @param maxWrites Bus writes allowed in this call (0 = no limit).
+ * @return HAL_OK, or the status of the first failed write.
+ */
+HAL_StatusTypeDef DAC8571_Coalesce_Process(DAC8571_CoalesceTypeDef *coalesce, uint16_t maxWrites);
+
+/**
+ * @brief Get the number of channels with a value waiting to be written.
+ * @param coalesce Pointer to the scheduler structure.
+ * @return Pending channel count.
+ */
+uint16_t DAC8571_Coalesce_GetPending(DAC8571_CoalesceTypeDef *coalesce);
+
+/**
+ * @brief Copy the coalescing counters.
+ * @param coalesce Pointer to the scheduler structure.
+ * @param stats Destination for the counters.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Coalesce_GetStats(DAC8571_CoalesceTypeDef *coalesce, DAC8571_CoalesceStatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* INC_DAC8571_COALESCE_H_ */
@@ -0,0 +1,124 @@
+/*
+ * @file    dac8571_log.c
+ * @author  lekhnitsky
+ * @brief   Deferred binary event log for the DAC8571 library.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_log.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <limits.h>
+
+#if (DAC8571_LOG_CAPACITY & (DAC8571_LOG_CAPACITY - 1)) != 0
+#error "DAC8571_LOG_CAPACITY must be a power of two"
+#endif
+
+/**
+ * @brief Ring slot. For position pos on lap = pos / DAC8571_LOG_CAPACITY, turn == 2 * lap means
+ *        free for the producer and 2 * lap + 1 means filled for the consumer; the zero-initialized
+ *        ring is therefore ready without setup.
+ */
+typedef struct {
+    atomic_uint turn;
+    DAC8571_LogRecordTypeDef record;
+} DAC8571_LogSlotTypeDef;
+
+#define LOG_LAP(pos)    ((pos) / DAC8571_LOG_CAPACITY)
+#define LOG_TURN_MASK   (2u * (UINT_MAX / DAC8571_LOG_CAPACITY + 1u) - 1u) ///< Turns wrap together with positions
+#define LOG_TURN(t)     ((t) & LOG_TURN_MASK)
+
+static DAC8571_LogSlotTypeDef logSlots[DAC8571_LOG_CAPACITY];
+static atomic_uint logHead;
+static unsigned int logTail;
+static atomic_uint logDropped;
+
+static const char *DAC8571_Log_EventName(uint8_t event) {
+    switch (event) {
+        case DAC8571_EVT_INIT_OK:         return "INIT_OK";
+        case DAC8571_EVT_INIT_FAIL:       return "INIT_FAIL";
+        case DAC8571_EVT_PROBE_FAIL:      return "PROBE_FAIL";
+        case DAC8571_EVT_WRITE_FAIL:      return "WRITE_FAIL";
+        case DAC8571_EVT_STREAM_FAIL:     return "STREAM_FAIL";
+        case DAC8571_EVT_READ_FAIL:       return "READ_FAIL";
+        case DAC8571_EVT_DMA_START_FAIL:  return "DMA_START_FAIL";
+        case DAC8571_EVT_DMA_ERROR:       return "DMA_ERROR";
+        case DAC8571_EVT_BROADCAST_FAIL:  return "BROADCAST_FAIL";
+        case DAC8571_EVT_BUFFER_OVERFLOW: return "BUFFER_OVERFLOW";
+        case DAC8571_EVT_BREAKER_OPEN:    return "BREAKER_OPEN";
+        case DAC8571_EVT_BUS_RECOVERY:    return "BUS_RECOVERY";
+        default:                          return "UNKNOWN_EVENT";
+    }
+}
+
+void DAC8571_Log_Write(uint8_t level, uint8_t event, uint8_t address, uint16_t value, uint8_t status) {
+    unsigned int pos = atomic_load_explicit(&logHead, memory_order_relaxed);
+    for (;;) {
+        DAC8571_LogSlotTypeDef *slot = &logSlots[pos & (DAC8571_LOG_CAPACITY - 1)];
+        unsigned int turn = atomic_load_explicit(&slot->turn, memory_order_acquire);
+        unsigned int diff = LOG_TURN(turn - 2 * LOG_LAP(pos));
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&logHead, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->record.timestamp = DAC8571_LOG_TIMESTAMP();
+                slot->record.value = value;
+                slot->record.event = event;
+                slot->record.level = level;
+                slot->record.address = address;
+                slot->record.status = status;
+                atomic_store_explicit(&slot->turn, LOG_TURN(2 * LOG_LAP(pos) + 1), memory_order_release);
+                return;
+            }
+        } else if (diff > LOG_TURN_MASK / 2) {
+            // Consumer has not freed this slot yet: ring full
+            atomic_fetch_add_explicit(&logDropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&logHead, memory_order_relaxed);
+        }
+    }
+}
+
+uint8_t DAC8571_Log_Pop(DAC8571_LogRecordTypeDef *record) {
+    if (!record) {
+        return 0;
+    }
+
+    DAC8571_LogSlotTypeDef *slot = &logSlots[logTail & (DAC8571_LOG_CAPACITY - 1)];
+    unsigned int turn = atomic_load_explicit(&slot->turn, memory_order_acquire);
+    if (turn != LOG_TURN(2 * LOG_LAP(logTail) + 1)) {
+        return 0;
+    }
+
+    *record = slot->record;
+    atomic_store_explicit(&slot->turn, LOG_TURN(2 * LOG_LAP(logTail) + 2), memory_order_release);
+    logTail++;
+    return 1;
+}
+
+uint32_t DAC8571_Log_GetDropped(void) {
+    return atomic_load_explicit(&logDropped, memory_order_relaxed);
+}
+
+int DAC8571_Log_Format(const DAC8571_LogRecordTypeDef *record, char *buffer, size_t size) {
+    static const char *levels[] = {"NONE", "ERROR", "WARN", "INFO"};
+    const char *level = (record->level <= DAC8571_LOG_LEVEL_INFO) ? levels[record->level] : "?";
+
+    return snprintf(buffer, size, "[%lu] %s %s addr=0x%02X value=0x%04X status=%u",
+                    (unsigned long)record->timestamp, level, DAC8571_Log_EventName(record->event),
+                    record->address, record->value, record->status);
+}
+
+uint32_t DAC8571_Log_Process(void) {
+    DAC8571_LogRecordTypeDef record;
+    char line[96];
+    uint32_t count = 0;
+
+    while (DAC8571_Log_Pop(&record)) {
+        DAC8571_Log_Format(&record, line, sizeof(line));
+        printf("%s\r\n", line);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,123 @@
+/*
+ * @file    dac8571_log.h
+ * @author  lekhnitsky
+ * @brief   Deferred binary event log for the DAC8571 library.
+ * @date    2025-01-17
+ */
+
+#ifndef INC_DAC8571_LOG_H_
+#define INC_DAC8571_LOG_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Compile-time log levels; records above DAC8571_LOG_LEVEL are compiled out.
+ */
+#define DAC8571_LOG_LEVEL_NONE      0 ///< Logging disabled (default)
+#define DAC8571_LOG_LEVEL_ERROR     1 ///< Failed transactions
+#define DAC8571_LOG_LEVEL_WARN      2 ///< Retries and recoverable conditions
+#define DAC8571_LOG_LEVEL_INFO      3 ///< Lifecycle events (init, state changes)
+
+#ifndef DAC8571_LOG_LEVEL
+#define DAC8571_LOG_LEVEL           DAC8571_LOG_LEVEL_NONE
+#endif
+
+#ifndef DAC8571_LOG_CAPACITY
+#define DAC8571_LOG_CAPACITY        64 ///< Ring size in records (power of two)
+#endif
+
+#ifndef DAC8571_LOG_TIMESTAMP
+#define DAC8571_LOG_TIMESTAMP()     HAL_GetTick() ///< Record timestamp source
+#endif
+
+/**
+ * @brief Event identifiers.
+ */
+#define DAC8571_EVT_INIT_OK         0x01 ///< Device answered during init
+#define DAC8571_EVT_INIT_FAIL       0x02 ///< Device did not answer during init
+#define DAC8571_EVT_PROBE_FAIL      0x03 ///< Single probe attempt failed
+#define DAC8571_EVT_WRITE_FAIL      0x04 ///< Single-value write failed
+#define DAC8571_EVT_STREAM_FAIL     0x05 ///< Burst write failed (value = samples in the burst)
+#define DAC8571_EVT_READ_FAIL       0x06 ///< Read failed
+#define DAC8571_EVT_DMA_START_FAIL  0x07 ///< DMA transfer could not be started
+#define DAC8571_EVT_DMA_ERROR       0x08 ///< DMA transfer completed with an error
+#define DAC8571_EVT_BROADCAST_FAIL  0x09 ///< Broadcast update failed
+#define DAC8571_EVT_BUFFER_OVERFLOW 0x0A ///< Array longer than the path allows (value = length)
+#define DAC8571_EVT_BREAKER_OPEN    0x0B ///< Circuit breaker opened (value = consecutive errors)
+#define DAC8571_EVT_BUS_RECOVERY    0x0C ///< Bus recovery performed (value = SCL pulses, status = result)
+
+/**
+ * @brief Compact binary log record.
+ */
+typedef struct {
+    uint32_t timestamp;  ///< DAC8571_LOG_TIMESTAMP() at the event
+    uint16_t value;      ///< Event-specific value (usually the DAC code)
+    uint8_t event;       ///< DAC8571_EVT_* identifier
+    uint8_t level;       ///< DAC8571_LOG_LEVEL_* of the record
+    uint8_t address;     ///< 7-bit I2C address of the device
+    uint8_t status;      ///< HAL status of the failed call
+} DAC8571_LogRecordTypeDef;
+
+/**
+ * @brief Append a record; lock-free, safe from any context. Drops the record when the ring is full.
+ */
+void DAC8571_Log_Write(uint8_t level, uint8_t event, uint8_t address, uint16_t value, uint8_t status);
+
+/**
+ * @brief Remove the oldest record (single consumer).
+ * @param record Destination for the record.
+ * @return 1 if a record was returned, 0 if the ring is empty.
+ */
+uint8_t DAC8571_Log_Pop(DAC8571_LogRecordTypeDef *record);
+
+/**
+ * @brief Number of records dropped because the ring was full.
+ */
+uint32_t DAC8571_Log_GetDropped(void);
+
+/**
+ * @brief Format a record as one line of text.
+ * @param record Record to format.
+ * @param buffer Destination buffer.
+ * @param size Size of the destination buffer.
+ * @return Number of characters written (as snprintf).
+ */
+int DAC8571_Log_Format(const DAC8571_LogRecordTypeDef *record, char *buffer, size_t size);
+
+/**
+ * @brief Drain the ring and print every record with printf; call from a background task.
+ * @return Number of records printed.
+ */
+uint32_t DAC8571_Log_Process(void);
+
+#if DAC8571_LOG_LEVEL >= DAC8571_LOG_LEVEL_ERROR
+  #define DAC8571_LOG_ERROR(evt, addr, val, st) DAC8571_Log_Write(DAC8571_LOG_LEVEL_ERROR, (evt), (uint8_t)(addr), (uint16_t)(val), (uint8_t)(st))
+#else
+  #define DAC8571_LOG_ERROR(evt, addr, val, st) do { /* nothing */ } while (0)
+#endif
+
+#if DAC8571_LOG_LEVEL >= DAC8571_LOG_LEVEL_WARN
+  #define DAC8571_LOG_WARN(evt, addr, val, st)  DAC8571_Log_Write(DAC8571_LOG_LEVEL_WARN, (evt), (uint8_t)(addr), (uint16_t)(val), (uint8_t)(st))
+#else
+  #define DAC8571_LOG_WARN(evt, addr, val, st)  do { /* nothing */ } while (0)
+#endif
+
+#if DAC8571_LOG_LEVEL >= DAC8571_LOG_LEVEL_INFO
+  #define DAC8571_LOG_INFO(evt, addr, val, st)  DAC8571_Log_Write(DAC8571_LOG_LEVEL_INFO, (evt), (uint8_t)(addr), (uint16_t)(val), (uint8_t)(st))
+#else
+  #define DAC8571_LOG_INFO(evt, addr, val, st)  do { /* nothing */ } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* INC_DAC8571_LOG_H_ */
@@ -0,0 +1,186 @@
+/*
+ * @file    dac8571_queue.c
+ * @author  lekhnitsky
+ * @brief   Lock-free setpoint queue from interrupt producers to the DAC8571 writer.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_queue.h"
+#include <stddef.h>
+
+/* The parked value has been written; clear it unless the producer replaced it meanwhile */
+static void DAC8571_Queue_ReleaseLatest(DAC8571_QueueTypeDef *queue, uint32_t latest) {
+    uint32_t expected = latest;
+    if (!__atomic_compare_exchange_n(&queue->latest, &expected, 0, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // The producer counted the value it replaced as discarded, but it made it to the bus
+        __atomic_fetch_sub(&queue->overflows, 1, __ATOMIC_RELAXED);
+    }
+}
+
+HAL_StatusTypeDef DAC8571_Queue_Init(DAC8571_QueueTypeDef *queue, DAC8571_HandleTypeDef *hdac8571,
+                                     uint16_t *buffer, uint32_t capacity, uint8_t policy) {
+    if (!queue || !hdac8571 || !buffer || capacity < 2 || capacity > 32768 ||
+        (capacity & (capacity - 1)) != 0 || policy > DAC8571_QUEUE_LATEST_WINS) {
+        return HAL_ERROR;
+    }
+
+    queue->hdac8571 = hdac8571;
+    queue->buffer = buffer;
+    queue->mask = capacity - 1;
+    queue->policy = policy;
+    queue->draining = 0;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->latest = 0;
+    queue->overflows = 0;
+    queue->highWater = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Queue_Push(DAC8571_QueueTypeDef *queue, uint16_t value) {
+    if (!queue || !queue->buffer) {
+        return HAL_ERROR;
+    }
+
+    uint32_t head = queue->head;
+    uint32_t count = head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+    if (queue->policy == DAC8571_QUEUE_LATEST_WINS) {
+        // Once a value is parked, newer ones replace it so it always stays behind the ring contents
+        if ((__atomic_load_n(&queue->latest, __ATOMIC_ACQUIRE) & DAC8571_QUEUE_LATEST_VALID) || count > queue->mask) {
+            uint32_t old = __atomic_exchange_n(&queue->latest, value | DAC8571_QUEUE_LATEST_VALID, __ATOMIC_RELEASE);
+            if (old & DAC8571_QUEUE_LATEST_VALID) {
+                __atomic_fetch_add(&queue->overflows, 1, __ATOMIC_RELAXED);
+            }
+            return HAL_OK;
+        }
+    } else if (count > queue->mask) {
+        __atomic_fetch_add(&queue->overflows, 1, __ATOMIC_RELAXED);
+        return HAL_BUSY;
+    }
+
+    queue->buffer[head & queue->mask] = value;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    if (count + 1 > queue->highWater) {
+        queue->highWater = count + 1;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Queue_Process(DAC8571_QueueTypeDef *queue) {
+    if (!queue || !queue->buffer) {
+        return HAL_ERROR;
+    }
+    if (__atomic_test_and_set(&queue->draining, __ATOMIC_ACQUIRE)) {
+        return HAL_BUSY;
+    }
+
+    // Stop at what was queued on entry so a fast producer cannot keep the writer here forever
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t end = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = queue->tail;
+    while (tail != end) {
+        uint32_t offset = tail & queue->mask;
+        uint32_t count = end - tail;
+
+        // One burst per contiguous run, split where the ring wraps
+        if (count > queue->mask + 1 - offset) {
+            count = queue->mask + 1 - offset;
+        }
+        if (count > DAC8571_STREAM_MAX_SAMPLES) {
+            count = DAC8571_STREAM_MAX_SAMPLES;
+        }
+
+        status = DAC8571_WriteStream(queue->hdac8571, &queue->buffer[offset], (uint16_t)count);
+        if (status != HAL_OK) {
+            break;
+        }
+        tail += count;
+        __atomic_store_n(&queue->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    // The parked value is newer than anything in the ring, so it only goes out once the ring is empty
+    if (status == HAL_OK && __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == tail) {
+        uint32_t latest = __atomic_load_n(&queue->latest, __ATOMIC_ACQUIRE);
+        if (latest & DAC8571_QUEUE_LATEST_VALID) {
+            uint16_t value = (uint16_t)latest;
+            status = DAC8571_WriteStream(queue->hdac8571, &value, 1);
+            if (status == HAL_OK) {
+                DAC8571_Queue_ReleaseLatest(queue, latest);
+            }
+        }
+    }
+
+    __atomic_clear(&queue->draining, __ATOMIC_RELEASE);
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Queue_ProcessAsync(DAC8571_QueueTypeDef *queue) {
+    if (!queue || !queue->buffer) {
+        return HAL_ERROR;
+    }
+    if (DAC8571_IsBusy(queue->hdac8571)) {
+        return HAL_BUSY;
+    }
+    if (__atomic_test_and_set(&queue->draining, __ATOMIC_ACQUIRE)) {
+        return HAL_BUSY;
+    }
+
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t tail = queue->tail;
+    uint32_t count = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) - tail;
+
+    if (count > 0) {
+        uint32_t offset = tail & queue->mask;
+        if (count > queue->mask + 1 - offset) {
+            count = queue->mask + 1 - offset;
+        }
+        if (count > DAC8571_ASYNC_MAX_SAMPLES) {
+            count = DAC8571_ASYNC_MAX_SAMPLES;
+        }
+
+        // The values are copied into the handle's DMA buffer, so the slots can be released at once
+        status = DAC8571_WriteArrayAsync(queue->hdac8571, &queue->buffer[offset], (uint16_t)count);
+        if (status == HAL_OK) {
+            __atomic_store_n(&queue->tail, tail + count, __ATOMIC_RELEASE);
+        }
+    } else {
+        uint32_t latest = __atomic_load_n(&queue->latest, __ATOMIC_ACQUIRE);
+        if (latest & DAC8571_QUEUE_LATEST_VALID) {
+            uint16_t value = (uint16_t)latest;
+            status = DAC8571_WriteArrayAsync(queue->hdac8571, &value, 1);
+            if (status == HAL_OK) {
+                DAC8571_Queue_ReleaseLatest(queue, latest);
+            }
+        }
+    }
+
+    __atomic_clear(&queue->draining, __ATOMIC_RELEASE);
+    return status;
+}
+
+uint32_t DAC8571_Queue_GetCount(DAC8571_QueueTypeDef *queue) {
+    if (!queue) {
+        return 0;
+    }
+
+    uint32_t count = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&queue->latest, __ATOMIC_ACQUIRE) & DAC8571_QUEUE_LATEST_VALID) {
+        count++;
+    }
+    return count;
+}
+
+uint32_t DAC8571_Queue_GetOverflows(DAC8571_QueueTypeDef *queue) {
+    if (!queue) {
+        return 0;
+    }
+    return __atomic_load_n(&queue->overflows, __ATOMIC_RELAXED);
+}
+
+uint32_t DAC8571_Queue_GetHighWater(DAC8571_QueueTypeDef *queue) {
+    if (!queue) {
+        return 0;
+    }
+    return queue->highWater;
+}
@@ -0,0 +1,110 @@
+/*
+ * @file    dac8571_queue.h
+ * @author  lekhnitsky
+ * @brief   Lock-free setpoint queue from interrupt producers to the DAC8571 writer.
+ * @date    2025-01-17
+ */
+
+#ifndef INC_DAC8571_QUEUE_H_
+#define INC_DAC8571_QUEUE_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dac8571.h"
+
+/**
+ * @brief Overflow policies.
+ */
+#define DAC8571_QUEUE_DROP_NEWEST   0x00 ///< Full queue rejects the new value
+#define DAC8571_QUEUE_LATEST_WINS   0x01 ///< Full queue keeps the newest value and discards the ones it replaces
+
+/**
+ * @brief Single-producer/single-consumer setpoint queue.
+ * @details The producer (typically a control ISR) calls DAC8571_Queue_Push; the consumer side
+ *          (DAC8571_Queue_Process, DAC8571_Queue_ProcessAsync) may be called from several contexts,
+ *          since a drain that finds another one running returns HAL_BUSY instead of interleaving.
+ *          With DAC8571_QUEUE_LATEST_WINS a value that does not fit is parked in a one-entry slot
+ *          that is always sent after everything already queued.
+ */
+typedef struct {
+    DAC8571_HandleTypeDef *hdac8571; ///< DAC the setpoints are written to
+    uint16_t *buffer;                ///< Ring storage (capacity values)
+    uint32_t mask;                   ///< capacity - 1
+    uint8_t policy;                  ///< DAC8571_QUEUE_DROP_NEWEST or DAC8571_QUEUE_LATEST_WINS
+    volatile uint8_t draining;       ///< Consumer claim flag
+    volatile uint32_t head;          ///< Free-running write index (producer)
+    volatile uint32_t tail;          ///< Free-running read index (consumer)
+    volatile uint32_t latest;        ///< Parked value | DAC8571_QUEUE_LATEST_VALID (LATEST_WINS only)
+    volatile uint32_t overflows;     ///< Values discarded because the queue was full
+    volatile uint32_t highWater;     ///< Largest number of values queued at once
+} DAC8571_QueueTypeDef;
+
+#define DAC8571_QUEUE_LATEST_VALID  0x10000UL ///< Marks DAC8571_QueueTypeDef::latest as holding a value
+
+/**
+ * @brief Initialize a setpoint queue.
+ * @param queue Pointer to the queue structure.
+ * @param hdac8571 Pointer to an initialized DAC8571 handle.
+ * @param buffer Ring storage of capacity values.
+ * @param capacity Number of values the ring holds (power of two, 2 to 32768).
+ * @param policy DAC8571_QUEUE_DROP_NEWEST or DAC8571_QUEUE_LATEST_WINS.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Queue_Init(DAC8571_QueueTypeDef *queue, DAC8571_HandleTypeDef *hdac8571,
+                                     uint16_t *buffer, uint32_t capacity, uint8_t policy);
+
+/**
+ * @brief Queue a setpoint; O(1), lock-free, safe from interrupt context (single producer).
+ * @param queue Pointer to the queue structure.
+ * @param value 16-bit DAC code.
+ * @return HAL_OK if the value will be written, HAL_BUSY if it was dropped (DAC8571_QUEUE_DROP_NEWEST).
+ */
+HAL_StatusTypeDef DAC8571_Queue_Push(DAC8571_QueueTypeDef *queue, uint16_t value);
+
+/**
+ * @brief Drain the queue with blocking DAC8571_WriteStream bursts; call from the writer task.
+ * @details Values stay queued if their burst fails, so a later call retries them.
+ * @param queue Pointer to the queue structure.
+ * @return HAL_OK when the queue is empty, HAL_BUSY if another drain is running, or the write status.
+ */
+HAL_StatusTypeDef DAC8571_Queue_Process(DAC8571_QueueTypeDef *queue);
+
+/**
+ * @brief Start one asynchronous burst (up to DAC8571_ASYNC_MAX_SAMPLES) of queued values.
+ * @details Call it from the handle's TxCplt callback to chain bursts, and after DAC8571_Queue_Push
+ *          (or from the main loop) to restart the chain once it has run dry.
+ * @param queue Pointer to the queue structure.
+ * @return HAL_OK if a burst was started or the queue is empty, HAL_BUSY if a transfer or drain is in progress.
+ */
+HAL_StatusTypeDef DAC8571_Queue_ProcessAsync(DAC8571_QueueTypeDef *queue);
+
+/**
+ * @brief Get the number of values waiting to be written.
+ * @param queue Pointer to the queue structure.
+ * @return Queued value count.
+ */
+uint32_t DAC8571_Queue_GetCount(DAC8571_QueueTypeDef *queue);
+
+/**
+ * @brief Get the number of values discarded because the queue was full.
+ * @param queue Pointer to the queue structure.
+ * @return Overflow count.
+ */
+uint32_t DAC8571_Queue_GetOverflows(DAC8571_QueueTypeDef *queue);
+
+/**
+ * @brief Get the largest number of values queued at once, for sizing the ring.
+ * @param queue Pointer to the queue structure.
+ * @return High-water mark.
+ */
+uint32_t DAC8571_Queue_GetHighWater(DAC8571_QueueTypeDef *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* INC_DAC8571_QUEUE_H_ */
@@ -0,0 +1,244 @@
+/*
+ * @file    dac8571_ramp.c
+ * @author  lekhnitsky
+ * @brief   Slew-rate-limited background ramps for I2C 16-bit DAC DAC8571.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_ramp.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// The ramp list is shared between tasks (starting ramps) and the timer interrupt
+#if defined(HAL_SIM) || defined(HAL_LINUX)
+  #define DAC8571_RAMP_LOCK()     do { } while (0)
+  #define DAC8571_RAMP_UNLOCK()   do { } while (0)
+#else
+  #define DAC8571_RAMP_LOCK()     uint32_t rampPrimask = __get_PRIMASK(); __disable_irq()
+  #define DAC8571_RAMP_UNLOCK()   __set_PRIMASK(rampPrimask)
+#endif
+
+static DAC8571_RampTypeDef *rampList;
+static TIM_HandleTypeDef *rampTimer;
+static uint32_t rampSampleRateHz;
+static uint16_t rampSamplesPerTick;
+
+/* A ramp on the engine list */
+static inline bool DAC8571_Ramp_Active(const DAC8571_RampTypeDef *ramp) {
+    return ramp->state == DAC8571_RAMP_RUNNING || ramp->state == DAC8571_RAMP_FINISHING;
+}
+
+/* Code the next ramp on this handle starts from */
+static uint16_t DAC8571_Ramp_From(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571) {
+    if (DAC8571_Ramp_Active(ramp) && ramp->hdac8571 == hdac8571) {
+        return ramp->code;
+    }
+    return hdac8571->lastValue;
+}
+
+static void DAC8571_Ramp_Unlink(DAC8571_RampTypeDef *ramp) {
+    for (DAC8571_RampTypeDef **link = &rampList; *link; link = &(*link)->next) {
+        if (*link == ramp) {
+            *link = ramp->next;
+            ramp->next = NULL;
+            return;
+        }
+    }
+}
+
+/* Take a ramp off the list at link and report it failed instead of done */
+static void DAC8571_Ramp_Fail(DAC8571_RampTypeDef **link, DAC8571_RampTypeDef *ramp) {
+    *link = ramp->next;
+    ramp->next = NULL;
+    ramp->state = DAC8571_RAMP_FAILED;
+    if (ramp->ErrorCallback) {
+        ramp->ErrorCallback(ramp);
+    }
+}
+
+HAL_StatusTypeDef DAC8571_Ramp_EngineStart(TIM_HandleTypeDef *htim, uint32_t tickHz, uint16_t samplesPerTick) {
+    if (!htim || tickHz == 0 || samplesPerTick == 0 || samplesPerTick > DAC8571_ASYNC_MAX_SAMPLES) {
+        return HAL_ERROR;
+    }
+
+    rampTimer = htim;
+    rampSamplesPerTick = samplesPerTick;
+    rampSampleRateHz = tickHz * samplesPerTick;
+    return HAL_TIM_Base_Start_IT(htim);
+}
+
+HAL_StatusTypeDef DAC8571_Ramp_EngineStop(void) {
+    if (!rampTimer) {
+        return HAL_ERROR;
+    }
+
+    HAL_StatusTypeDef status = HAL_TIM_Base_Stop_IT(rampTimer);
+    rampTimer = NULL;
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Ramp_ToCode(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571, uint16_t target, uint32_t samples) {
+    if (!ramp || !hdac8571 || samples == 0) {
+        return HAL_ERROR;
+    }
+
+    DAC8571_RAMP_LOCK();
+    for (DAC8571_RampTypeDef *other = rampList; other; other = other->next) {
+        if (other != ramp && other->hdac8571 == hdac8571) {
+            DAC8571_RAMP_UNLOCK();
+            return HAL_BUSY;
+        }
+    }
+
+    uint16_t start = DAC8571_Ramp_From(ramp, hdac8571);
+    int32_t delta = (int32_t)target - (int32_t)start;
+    uint32_t magnitude = (uint32_t)((delta < 0) ? -delta : delta);
+
+    ramp->hdac8571 = hdac8571;
+    ramp->code = start;
+    ramp->target = target;
+    ramp->step = delta / (int32_t)samples;
+    ramp->direction = (delta < 0) ? -1 : 1;
+    ramp->remainder = magnitude % samples;
+    ramp->error = 0;
+    ramp->samples = samples;
+    ramp->remaining = samples;
+    ramp->missedTicks = 0;
+    if (!DAC8571_Ramp_Active(ramp)) {
+        ramp->burstSent = 0;
+        ramp->next = rampList;
+        rampList = ramp;
+    }
+    ramp->state = DAC8571_RAMP_RUNNING;
+    DAC8571_RAMP_UNLOCK();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Ramp_Slew(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571, float voltage, float voltsPerSecond) {
+    if (!ramp || !hdac8571 || !(voltsPerSecond > 0.0f) || rampSampleRateHz == 0) {
+        return HAL_ERROR;
+    }
+
+    uint16_t target;
+    HAL_StatusTypeDef status = DAC8571_VoltsToCodes(hdac8571, &voltage, &target, 1);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // The only floating point: turn the slew limit into a sample count once
+    int32_t delta = (int32_t)target - (int32_t)DAC8571_Ramp_From(ramp, hdac8571);
+    float seconds = (float)((delta < 0) ? -delta : delta) / (hdac8571->codesPerVolt * voltsPerSecond);
+    float exact = seconds * (float)rampSampleRateHz;
+    uint32_t samples = (exact >= 4294967040.0f) ? UINT32_MAX : (uint32_t)exact;
+    if ((float)samples < exact) {
+        samples++;
+    }
+    return DAC8571_Ramp_ToCode(ramp, hdac8571, target, (samples == 0) ? 1U : samples);
+}
+
+HAL_StatusTypeDef DAC8571_Ramp_Duration(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571, float voltage, uint32_t durationMs) {
+    if (!ramp || !hdac8571 || rampSampleRateHz == 0) {
+        return HAL_ERROR;
+    }
+
+    uint16_t target;
+    HAL_StatusTypeDef status = DAC8571_VoltsToCodes(hdac8571, &voltage, &target, 1);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    uint64_t samples = (uint64_t)durationMs * rampSampleRateHz / 1000U;
+    if (samples > UINT32_MAX) {
+        samples = UINT32_MAX;
+    }
+    return DAC8571_Ramp_ToCode(ramp, hdac8571, target, (samples == 0) ? 1U : (uint32_t)samples);
+}
+
+HAL_StatusTypeDef DAC8571_Ramp_Abort(DAC8571_RampTypeDef *ramp) {
+    if (!ramp) {
+        return HAL_ERROR;
+    }
+
+    DAC8571_RAMP_LOCK();
+    if (DAC8571_Ramp_Active(ramp)) {
+        DAC8571_Ramp_Unlink(ramp);
+    }
+    ramp->state = DAC8571_RAMP_IDLE;
+    DAC8571_RAMP_UNLOCK();
+    return HAL_OK;
+}
+
+void DAC8571_Ramp_TimerHandler(TIM_HandleTypeDef *htim) {
+    if (!htim || htim != rampTimer) {
+        return;
+    }
+
+    DAC8571_RAMP_LOCK();
+    DAC8571_RampTypeDef **link = &rampList;
+    while (*link) {
+        DAC8571_RampTypeDef *ramp = *link;
+        bool busy = DAC8571_IsBusy(ramp->hdac8571);
+
+        // The previous burst ended in an I2C error: the device holds an older code
+        if (ramp->burstSent && !busy && ramp->hdac8571->lastError == DAC8571_I2C_ERROR) {
+            DAC8571_Ramp_Fail(link, ramp);
+            continue;
+        }
+
+        // The last burst has left the bus: the output is at the target
+        if (ramp->state == DAC8571_RAMP_FINISHING) {
+            if (busy) {
+                link = &ramp->next;
+                continue;
+            }
+            *link = ramp->next;
+            ramp->next = NULL;
+            ramp->state = DAC8571_RAMP_IDLE;
+            if (ramp->DoneCallback) {
+                ramp->DoneCallback(ramp);
+            }
+            continue;
+        }
+
+        uint16_t count = (ramp->remaining < rampSamplesPerTick) ? (uint16_t)ramp->remaining : rampSamplesPerTick;
+        uint16_t codes[DAC8571_ASYNC_MAX_SAMPLES];
+        int32_t code = ramp->code;
+        uint32_t error = ramp->error;
+        for (uint16_t i = 0; i < count; i++) {
+            code += ramp->step;
+            error += ramp->remainder;
+            if (error >= ramp->samples) {
+                error -= ramp->samples;
+                code += ramp->direction;
+            }
+            codes[i] = (uint16_t)code;
+        }
+
+        HAL_StatusTypeDef status = DAC8571_WriteArrayAsync(ramp->hdac8571, codes, count);
+        if (status == HAL_OK) {
+            ramp->code = (uint16_t)code;
+            ramp->error = error;
+            ramp->remaining -= count;
+            ramp->burstSent = 1;
+            if (ramp->remaining == 0) {
+                ramp->state = DAC8571_RAMP_FINISHING;
+            }
+        } else if (status == HAL_BUSY) {
+            // Device or bus busy (or breaker open): hold the output and resume on the next tick
+            ramp->missedTicks++;
+        } else {
+            // Retrying would not help
+            DAC8571_Ramp_Fail(link, ramp);
+            continue;
+        }
+        link = &ramp->next;
+    }
+    DAC8571_RAMP_UNLOCK();
+}
+
+uint8_t DAC8571_Ramp_GetState(DAC8571_RampTypeDef *ramp) {
+    if (!ramp) {
+        return DAC8571_RAMP_IDLE;
+    }
+    return ramp->state;
+}
@@ -0,0 +1,130 @@
+/*
+ * @file    dac8571_ramp.h
+ * @author  lekhnitsky
+ * @brief   Slew-rate-limited background ramps for I2C 16-bit DAC DAC8571.
+ * @date    2025-01-17
+ */
+
+#ifndef INC_DAC8571_RAMP_H_
+#define INC_DAC8571_RAMP_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dac8571.h"
+
+/**
+ * @brief Ramp states.
+ */
+#define DAC8571_RAMP_IDLE           0x00 ///< Not started, finished or aborted
+#define DAC8571_RAMP_RUNNING        0x01 ///< Codes still to be sent
+#define DAC8571_RAMP_FINISHING      0x02 ///< Last burst on the bus; DoneCallback follows on the next tick
+#define DAC8571_RAMP_FAILED         0x03 ///< A burst failed; the output holds the last code the device acknowledged
+
+/**
+ * @brief One ramp: codes from the current output to a target, generated with integer steps.
+ * @details Sample k of n is start + (target - start) * k / n, produced incrementally as a
+ *          whole-code step plus a remainder accumulator, so the last sample is exactly the target.
+ *          Zero-initialize the structure once; DoneCallback and ErrorCallback are kept across ramps.
+ */
+typedef struct __DAC8571_RampTypeDef {
+    DAC8571_HandleTypeDef *hdac8571;  ///< DAC the ramp is written to
+    uint16_t code;                    ///< Last code generated
+    uint16_t target;                  ///< Final code
+    int32_t step;                     ///< Whole codes added per sample
+    int8_t direction;                 ///< +1 or -1: sign of the remainder correction
+    uint32_t remainder;               ///< |target - start| mod samples
+    uint32_t error;                   ///< Remainder accumulator (0..samples-1)
+    uint32_t samples;                 ///< Samples in the ramp
+    uint32_t remaining;               ///< Samples not yet sent
+    volatile uint8_t state;           ///< DAC8571_RAMP_* state
+    uint32_t missedTicks;             ///< Ticks skipped because the device or bus was busy
+    uint8_t burstSent;                ///< A burst of this ramp has been started on the handle
+    void (*DoneCallback)(struct __DAC8571_RampTypeDef *ramp); ///< Called from the timer interrupt once the target is on the output
+    void (*ErrorCallback)(struct __DAC8571_RampTypeDef *ramp); ///< Called from the timer interrupt when the ramp fails
+    struct __DAC8571_RampTypeDef *next; ///< Engine list link
+} DAC8571_RampTypeDef;
+
+/**
+ * @brief Start the ramp engine on a periodic timer.
+ * @details Every tick each running ramp sends up to samplesPerTick codes in one asynchronous burst
+ *          (DAC8571_WriteArrayAsync), so ramps advance at tickHz * samplesPerTick samples per second.
+ *          The codes of a burst leave back to back on the bus, so pick samplesPerTick to fill roughly
+ *          one tick of bus time (about 18 SCL periods per code) for an evenly spaced staircase.
+ *          Ramps on one bus share it: a burst that finds the bus still busy waits for the next tick
+ *          (counted in missedTicks), which slows that ramp but never makes it steeper. A burst that
+ *          cannot be started or ends in an I2C error stops the ramp in DAC8571_RAMP_FAILED and calls
+ *          ErrorCallback instead of DoneCallback.
+ * @param htim Timer configured for tickHz; forward its update interrupt to DAC8571_Ramp_TimerHandler.
+ * @param tickHz Timer update rate.
+ * @param samplesPerTick Codes per burst (1 to DAC8571_ASYNC_MAX_SAMPLES).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Ramp_EngineStart(TIM_HandleTypeDef *htim, uint32_t tickHz, uint16_t samplesPerTick);
+
+/**
+ * @brief Stop the ramp engine; running ramps hold their current output until it is restarted.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Ramp_EngineStop(void);
+
+/**
+ * @brief Ramp to a code over a number of samples.
+ * @details Starts from the handle's last value, or from the current code when the same ramp
+ *          is retargeted while running. A handle can be driven by one ramp at a time.
+ * @param ramp Pointer to the ramp structure.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param target Final 16-bit code.
+ * @param samples Number of codes sent, the last one being target (at least 1).
+ * @return HAL_OK, or HAL_BUSY if another ramp is driving the handle.
+ */
+HAL_StatusTypeDef DAC8571_Ramp_ToCode(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571, uint16_t target, uint32_t samples);
+
+/**
+ * @brief Ramp to a voltage no faster than a slew rate.
+ * @param ramp Pointer to the ramp structure.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param voltage Target voltage (converted and calibrated as DAC8571_SetVoltage).
+ * @param voltsPerSecond Maximum slew rate.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Ramp_Slew(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571, float voltage, float voltsPerSecond);
+
+/**
+ * @brief Ramp to a voltage over a fixed duration.
+ * @param ramp Pointer to the ramp structure.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param voltage Target voltage (converted and calibrated as DAC8571_SetVoltage).
+ * @param durationMs Ramp duration in milliseconds.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Ramp_Duration(DAC8571_RampTypeDef *ramp, DAC8571_HandleTypeDef *hdac8571, float voltage, uint32_t durationMs);
+
+/**
+ * @brief Abort a ramp; the output keeps the last code sent and DoneCallback is not called.
+ * @param ramp Pointer to the ramp structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Ramp_Abort(DAC8571_RampTypeDef *ramp);
+
+/**
+ * @brief Advance every running ramp by one burst; call from HAL_TIM_PeriodElapsedCallback.
+ * @param htim Timer that elapsed (ignored if it is not the engine's timer).
+ */
+void DAC8571_Ramp_TimerHandler(TIM_HandleTypeDef *htim);
+
+/**
+ * @brief Get the state of a ramp.
+ * @param ramp Pointer to the ramp structure.
+ * @return DAC8571_RAMP_IDLE, DAC8571_RAMP_RUNNING, DAC8571_RAMP_FINISHING or DAC8571_RAMP_FAILED.
+ */
+uint8_t DAC8571_Ramp_GetState(DAC8571_RampTypeDef *ramp);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* INC_DAC8571_RAMP_H_ */
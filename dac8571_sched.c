@@ -0,0 +1,293 @@
+/*
+ * @file    dac8571_sched.c
+ * @author  lekhnitsky
+ * @brief   Deadline-ordered setpoint scheduler for I2C 16-bit DAC DAC8571.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_sched.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// The heap is shared between tasks (DAC8571_ScheduleWrite) and the timer interrupt
+#if defined(HAL_SIM) || defined(HAL_LINUX)
+  #define DAC8571_SCHED_LOCK()    do { } while (0)
+  #define DAC8571_SCHED_UNLOCK()  do { } while (0)
+#else
+  #define DAC8571_SCHED_LOCK()    uint32_t schedPrimask = __get_PRIMASK(); __disable_irq()
+  #define DAC8571_SCHED_UNLOCK()  __set_PRIMASK(schedPrimask)
+#endif
+
+#ifndef DAC8571_SCHED_TIME_US
+#if defined(HAL_SIM)
+  #define DAC8571_SCHED_TIME_US() ((uint32_t)(SIM_GetTimeNs() / 1000U))
+#elif defined(HAL_LINUX)
+#include <time.h>
+
+static uint32_t DAC8571_Sched_HostTimeUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000U);
+}
+  #define DAC8571_SCHED_TIME_US() DAC8571_Sched_HostTimeUs()
+#else
+static uint32_t schedLastCycles;
+static uint32_t schedCycleRemainder;
+static uint32_t schedTimeUs;
+
+/**
+ * @brief Extend the DWT cycle counter to a 32-bit microsecond clock.
+ * @details Called with the scheduler lock held and at least once per counter wrap
+ *          (about 25 s at 168 MHz), which the dispatch tick guarantees while running.
+ */
+static uint32_t DAC8571_Sched_CycleTimeUs(void) {
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+    uint32_t now = DWT->CYCCNT;
+
+    schedCycleRemainder += now - schedLastCycles;
+    schedLastCycles = now;
+    schedTimeUs += schedCycleRemainder / cyclesPerUs;
+    schedCycleRemainder %= cyclesPerUs;
+    return schedTimeUs;
+}
+  #define DAC8571_SCHED_TIME_US() DAC8571_Sched_CycleTimeUs()
+#endif
+#endif
+
+/**
+ * @brief Scheduled write; seq keeps writes with equal deadlines in submission order.
+ */
+typedef struct {
+    uint32_t dueUs;
+    uint32_t seq;
+    DAC8571_HandleTypeDef *hdac8571;
+    uint16_t value;
+} DAC8571_SchedEntryTypeDef;
+
+static DAC8571_SchedEntryTypeDef schedHeap[DAC8571_SCHED_CAPACITY];
+static uint16_t schedCount;
+static uint32_t schedSeq;
+static TIM_HandleTypeDef *schedTimer;
+static uint32_t schedLeadUs;
+static DAC8571_SchedStatsTypeDef schedStats;
+
+/* Deadlines compare modulo 2^32 so the clock may wrap */
+static inline bool DAC8571_Sched_Before(const DAC8571_SchedEntryTypeDef *a, const DAC8571_SchedEntryTypeDef *b) {
+    int32_t diff = (int32_t)(a->dueUs - b->dueUs);
+    if (diff != 0) {
+        return diff < 0;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void DAC8571_Sched_SiftUp(uint16_t i) {
+    DAC8571_SchedEntryTypeDef entry = schedHeap[i];
+    while (i > 0) {
+        uint16_t parent = (uint16_t)((i - 1) / 2);
+        if (!DAC8571_Sched_Before(&entry, &schedHeap[parent])) {
+            break;
+        }
+        schedHeap[i] = schedHeap[parent];
+        i = parent;
+    }
+    schedHeap[i] = entry;
+}
+
+static void DAC8571_Sched_SiftDown(uint16_t i) {
+    DAC8571_SchedEntryTypeDef entry = schedHeap[i];
+    for (;;) {
+        uint16_t child = (uint16_t)(2 * i + 1);
+        if (child >= schedCount) {
+            break;
+        }
+        if (child + 1 < schedCount && DAC8571_Sched_Before(&schedHeap[child + 1], &schedHeap[child])) {
+            child++;
+        }
+        if (!DAC8571_Sched_Before(&schedHeap[child], &entry)) {
+            break;
+        }
+        schedHeap[i] = schedHeap[child];
+        i = child;
+    }
+    schedHeap[i] = entry;
+}
+
+static void DAC8571_Sched_Pop(void) {
+    schedCount--;
+    if (schedCount > 0) {
+        schedHeap[0] = schedHeap[schedCount];
+        DAC8571_Sched_SiftDown(0);
+    }
+}
+
+static void DAC8571_Sched_Record(uint32_t dispatchLatencyUs) {
+    schedStats.dispatched++;
+    if (dispatchLatencyUs < schedStats.minDispatchLatencyUs || schedStats.dispatched == 1) {
+        schedStats.minDispatchLatencyUs = dispatchLatencyUs;
+    }
+    if (dispatchLatencyUs > schedStats.maxDispatchLatencyUs) {
+        schedStats.maxDispatchLatencyUs = dispatchLatencyUs;
+    }
+    schedStats.totalDispatchLatencyUs += dispatchLatencyUs;
+
+    uint8_t bucket = (uint8_t)(31 - __builtin_clz(dispatchLatencyUs | 1));
+    if (bucket >= DAC8571_SCHED_HIST_BUCKETS) {
+        bucket = DAC8571_SCHED_HIST_BUCKETS - 1;
+    }
+    schedStats.histogram[bucket]++;
+}
+
+HAL_StatusTypeDef DAC8571_Sched_Start(TIM_HandleTypeDef *htim, uint32_t leadUs) {
+    if (!htim) {
+        return HAL_ERROR;
+    }
+
+#if !defined(HAL_SIM) && !defined(HAL_LINUX)
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+#endif
+    schedTimer = htim;
+    schedLeadUs = leadUs;
+    return HAL_TIM_Base_Start_IT(htim);
+}
+
+HAL_StatusTypeDef DAC8571_Sched_Stop(void) {
+    if (!schedTimer) {
+        return HAL_ERROR;
+    }
+
+    HAL_StatusTypeDef status = HAL_TIM_Base_Stop_IT(schedTimer);
+    schedTimer = NULL;
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_ScheduleWrite(DAC8571_HandleTypeDef *hdac8571, uint16_t value, uint32_t t_us) {
+    if (!hdac8571) {
+        return HAL_ERROR;
+    }
+
+    HAL_StatusTypeDef status = HAL_OK;
+    DAC8571_SCHED_LOCK();
+    if (schedCount >= DAC8571_SCHED_CAPACITY) {
+        schedStats.overflows++;
+        status = HAL_BUSY;
+    } else {
+        DAC8571_SchedEntryTypeDef *entry = &schedHeap[schedCount];
+        entry->dueUs = t_us;
+        entry->seq = schedSeq++;
+        entry->hdac8571 = hdac8571;
+        entry->value = value;
+        DAC8571_Sched_SiftUp(schedCount++);
+    }
+    DAC8571_SCHED_UNLOCK();
+    return status;
+}
+
+uint16_t DAC8571_Sched_Cancel(DAC8571_HandleTypeDef *hdac8571) {
+    uint16_t removed = 0;
+
+    DAC8571_SCHED_LOCK();
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < schedCount; i++) {
+        if (schedHeap[i].hdac8571 == hdac8571) {
+            removed++;
+        } else {
+            schedHeap[kept++] = schedHeap[i];
+        }
+    }
+    schedCount = kept;
+    // Rebuild the heap bottom-up
+    for (uint16_t i = schedCount / 2; i-- > 0;) {
+        DAC8571_Sched_SiftDown(i);
+    }
+    DAC8571_SCHED_UNLOCK();
+    return removed;
+}
+
+void DAC8571_Sched_TimerHandler(TIM_HandleTypeDef *htim) {
+    if (!htim || htim != schedTimer) {
+        return;
+    }
+
+    DAC8571_SCHED_LOCK();
+    uint32_t now = DAC8571_SCHED_TIME_US();
+    I2C_HandleTypeDef *blocked[DAC8571_MAX_BUSES];
+    uint8_t blockedCount = 0;
+    uint16_t setAside = 0;
+    while (schedCount > 0) {
+        DAC8571_SchedEntryTypeDef entry = schedHeap[0];
+        uint32_t startUs = entry.dueUs - schedLeadUs;
+        if ((int32_t)(now - startUs) < 0) {
+            break;
+        }
+
+        // Writes behind a busy bus keep their order there without holding up other buses
+        bool wait = false;
+        for (uint8_t i = 0; i < blockedCount; i++) {
+            wait |= (blocked[i] == entry.hdac8571->hi2c);
+        }
+        HAL_StatusTypeDef status = HAL_BUSY;
+        if (!wait) {
+            status = DAC8571_WriteAsync(entry.hdac8571, entry.value);
+            if (status == HAL_BUSY && DAC8571_GetBreakerState(entry.hdac8571) != DAC8571_BREAKER_OPEN) {
+                wait = true;
+                if (blockedCount < DAC8571_MAX_BUSES) {
+                    blocked[blockedCount++] = entry.hdac8571->hi2c;
+                }
+            }
+        }
+
+        // Deferred entries stay packed just past the heap: the last one fills the slot Pop gave up
+        DAC8571_Sched_Pop();
+        if (setAside > 0) {
+            schedHeap[schedCount] = schedHeap[schedCount + setAside];
+        }
+        if (wait) {
+            schedStats.deferred++;
+            schedHeap[schedCount + setAside++] = entry;
+        } else if (status == HAL_OK) {
+            // Start of the transfer against its planned start; the latch follows one transfer time later
+            DAC8571_Sched_Record(now - startUs);
+        } else {
+            schedStats.failed++;
+        }
+    }
+
+    // Put the deferred writes back for the next tick
+    while (setAside-- > 0) {
+        DAC8571_Sched_SiftUp(schedCount++);
+    }
+    DAC8571_SCHED_UNLOCK();
+}
+
+uint32_t DAC8571_Sched_GetTimeUs(void) {
+    DAC8571_SCHED_LOCK();
+    uint32_t now = DAC8571_SCHED_TIME_US();
+    DAC8571_SCHED_UNLOCK();
+    return now;
+}
+
+uint16_t DAC8571_Sched_GetPending(void) {
+    return schedCount;
+}
+
+HAL_StatusTypeDef DAC8571_Sched_GetStats(DAC8571_SchedStatsTypeDef *stats) {
+    if (!stats) {
+        return HAL_ERROR;
+    }
+
+    DAC8571_SCHED_LOCK();
+    *stats = schedStats;
+    DAC8571_SCHED_UNLOCK();
+    return HAL_OK;
+}
+
+void DAC8571_Sched_ResetStats(void) {
+    DAC8571_SCHED_LOCK();
+    memset(&schedStats, 0, sizeof(schedStats));
+    DAC8571_SCHED_UNLOCK();
+}
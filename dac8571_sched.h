@@ -0,0 +1,122 @@
+/*
+ * @file    dac8571_sched.h
+ * @author  lekhnitsky
+ * @brief   Deadline-ordered setpoint scheduler for I2C 16-bit DAC DAC8571.
+ * @date    2025-01-17
+ */
+
+#ifndef INC_DAC8571_SCHED_H_
+#define INC_DAC8571_SCHED_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dac8571.h"
+
+#ifndef DAC8571_SCHED_CAPACITY
+#define DAC8571_SCHED_CAPACITY      32 ///< Writes that can be scheduled at once
+#endif
+
+#define DAC8571_SCHED_HIST_BUCKETS  16 ///< Dispatch latency histogram buckets (log2 microseconds)
+
+/*
+ * Time base: DAC8571_SCHED_TIME_US() returns a free-running 32-bit microsecond count.
+ * By default it extends the DWT cycle counter on target and follows the virtual clock
+ * in the simulator; define it (e.g. as __HAL_TIM_GET_COUNTER(&htim2) with TIM2 running
+ * at 1 MHz) to use a hardware timer instead.
+ */
+
+/**
+ * @brief Scheduler timing counters.
+ * @details Dispatch latency is the time the transfer was started minus (requested time - lead), in
+ *          microseconds: at most one timer tick unless the write was deferred behind a busy bus.
+ *          It is not the output error: the write latches when the transfer completes, so the output
+ *          lands at requested time + dispatch latency + (transfer time - lead).
+ */
+typedef struct {
+    uint32_t dispatched;                        ///< Writes started
+    uint32_t failed;                            ///< Writes that could not be started (dropped)
+    uint32_t deferred;                          ///< Due writes held over a tick by a busy device or bus
+    uint32_t overflows;                         ///< DAC8571_ScheduleWrite calls rejected because the heap was full
+    uint32_t minDispatchLatencyUs;              ///< Smallest dispatch latency
+    uint32_t maxDispatchLatencyUs;              ///< Largest dispatch latency
+    uint64_t totalDispatchLatencyUs;            ///< Sum of dispatch latencies (mean = total / dispatched)
+    uint32_t histogram[DAC8571_SCHED_HIST_BUCKETS]; ///< Bucket 0 holds dispatch latency 0-1 us, bucket i holds [2^i, 2^(i+1)) us
+} DAC8571_SchedStatsTypeDef;
+
+/**
+ * @brief Start dispatching scheduled writes from a periodic timer interrupt.
+ * @details The timer period is the dispatch resolution. Writes go out with DAC8571_WriteAsync,
+ *          leadUs ahead of their requested time, so set leadUs to the transfer time of one write
+ *          (about 38 SCL periods) for the output to latch on time.
+ * @param htim Timer configured for the dispatch tick; forward its update interrupt to
+ *             DAC8571_Sched_TimerHandler.
+ * @param leadUs Microseconds a write is started ahead of its requested time.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Sched_Start(TIM_HandleTypeDef *htim, uint32_t leadUs);
+
+/**
+ * @brief Stop dispatching; writes still scheduled stay in the heap.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Sched_Stop(void);
+
+/**
+ * @brief Schedule a write of a value at an absolute time.
+ * @details Writes due at the same time go out in the order they were scheduled. A time already
+ *          in the past is dispatched on the next tick and shows up as dispatch latency.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @param value 16-bit value to write.
+ * @param t_us Requested time on the DAC8571_Sched_GetTimeUs() clock (within 2^31 us of now).
+ * @return HAL_OK, or HAL_BUSY if DAC8571_SCHED_CAPACITY writes are already scheduled.
+ */
+HAL_StatusTypeDef DAC8571_ScheduleWrite(DAC8571_HandleTypeDef *hdac8571, uint16_t value, uint32_t t_us);
+
+/**
+ * @brief Remove every scheduled write for a handle.
+ * @param hdac8571 Pointer to the DAC8571 handle structure.
+ * @return Number of writes removed.
+ */
+uint16_t DAC8571_Sched_Cancel(DAC8571_HandleTypeDef *hdac8571);
+
+/**
+ * @brief Dispatch every write that is due; call from HAL_TIM_PeriodElapsedCallback.
+ * @details A due write whose device or bus is still busy waits for the next tick, and so do
+ *          the later writes on that bus; writes due on other buses still go out in deadline order.
+ * @param htim Timer that elapsed (ignored if it is not the scheduler's timer).
+ */
+void DAC8571_Sched_TimerHandler(TIM_HandleTypeDef *htim);
+
+/**
+ * @brief Get the scheduler clock.
+ * @return Current time in microseconds.
+ */
+uint32_t DAC8571_Sched_GetTimeUs(void);
+
+/**
+ * @brief Get the number of writes waiting to be dispatched.
+ * @return Scheduled write count.
+ */
+uint16_t DAC8571_Sched_GetPending(void);
+
+/**
+ * @brief Copy the scheduler timing counters.
+ * @param stats Destination for the counters.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Sched_GetStats(DAC8571_SchedStatsTypeDef *stats);
+
+/**
+ * @brief Clear the scheduler timing counters.
+ */
+void DAC8571_Sched_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* INC_DAC8571_SCHED_H_ */
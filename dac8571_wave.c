@@ -0,0 +1,137 @@
+/*
+ * @file    dac8571_wave.c
+ * @author  lekhnitsky
+ * @brief   Timer-paced waveform player for I2C 16-bit DAC DAC8571.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_wave.h"
+#include <stddef.h>
+
+HAL_StatusTypeDef DAC8571_Wave_Init(DAC8571_WaveTypeDef *wave, DAC8571_HandleTypeDef *hdac8571,
+                                    TIM_HandleTypeDef *htim, uint16_t *ring, uint16_t halfLength) {
+    if (!wave || !hdac8571 || !htim || !ring || halfLength == 0 || halfLength > DAC8571_WAVE_MAX_HALF_LENGTH) {
+        return HAL_ERROR;
+    }
+
+    wave->hdac8571 = hdac8571;
+    wave->htim = htim;
+    wave->ring = ring;
+    wave->halfLength = halfLength;
+    wave->position = 0;
+    wave->halfReady[0] = 0;
+    wave->halfReady[1] = 0;
+    wave->state = DAC8571_WAVE_STOPPED;
+    wave->samplesPlayed = 0;
+    wave->underruns = 0;
+    wave->missedTicks = 0;
+    wave->HalfCpltCallback = NULL;
+    wave->UnderrunCallback = NULL;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef DAC8571_Wave_Start(DAC8571_WaveTypeDef *wave) {
+    if (!wave || !wave->ring) {
+        return HAL_ERROR;
+    }
+    if (wave->state != DAC8571_WAVE_STOPPED) {
+        return HAL_BUSY;
+    }
+
+    wave->position = 0;
+    wave->halfReady[0] = 1;
+    wave->halfReady[1] = 1;
+    wave->samplesPlayed = 0;
+    wave->underruns = 0;
+    wave->missedTicks = 0;
+    wave->state = DAC8571_WAVE_RUNNING;
+
+    HAL_StatusTypeDef status = HAL_TIM_Base_Start_IT(wave->htim);
+    if (status != HAL_OK) {
+        wave->state = DAC8571_WAVE_STOPPED;
+    }
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Wave_Stop(DAC8571_WaveTypeDef *wave) {
+    if (!wave) {
+        return HAL_ERROR;
+    }
+
+    HAL_StatusTypeDef status = HAL_TIM_Base_Stop_IT(wave->htim);
+    wave->state = DAC8571_WAVE_STOPPED;
+    return status;
+}
+
+HAL_StatusTypeDef DAC8571_Wave_HalfReady(DAC8571_WaveTypeDef *wave, uint16_t *half) {
+    if (!wave) {
+        return HAL_ERROR;
+    }
+
+    if (half == wave->ring) {
+        wave->halfReady[0] = 1;
+    } else if (half == wave->ring + wave->halfLength) {
+        wave->halfReady[1] = 1;
+    } else {
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+void DAC8571_Wave_TimerHandler(DAC8571_WaveTypeDef *wave, TIM_HandleTypeDef *htim) {
+    if (!wave || htim != wave->htim || wave->state == DAC8571_WAVE_STOPPED) {
+        return;
+    }
+
+    uint16_t position = wave->position;
+    uint8_t half = (position < wave->halfLength) ? 0 : 1;
+
+    // Hold the output until the application hands this half back
+    if (!wave->halfReady[half]) {
+        if (wave->state != DAC8571_WAVE_UNDERRUN) {
+            wave->state = DAC8571_WAVE_UNDERRUN;
+            wave->underruns++;
+            if (wave->UnderrunCallback) {
+                wave->UnderrunCallback(wave);
+            }
+        }
+        return;
+    }
+    wave->state = DAC8571_WAVE_RUNNING;
+
+    // Previous sample still on the bus: the timer period is shorter than the transfer
+    if (DAC8571_WriteAsync(wave->hdac8571, wave->ring[position]) != HAL_OK) {
+        wave->missedTicks++;
+        return;
+    }
+    wave->samplesPlayed++;
+
+    position++;
+    if (position == wave->halfLength || position == 2 * wave->halfLength) {
+        uint16_t *done = (half == 0) ? wave->ring : wave->ring + wave->halfLength;
+        wave->halfReady[half] = 0;
+        if (position == 2 * wave->halfLength) {
+            position = 0;
+        }
+        wave->position = position;
+        if (wave->HalfCpltCallback) {
+            wave->HalfCpltCallback(wave, done);
+        }
+        return;
+    }
+    wave->position = position;
+}
+
+uint8_t DAC8571_Wave_GetState(DAC8571_WaveTypeDef *wave) {
+    if (!wave) {
+        return DAC8571_WAVE_STOPPED;
+    }
+    return wave->state;
+}
+
+uint32_t DAC8571_Wave_GetUnderruns(DAC8571_WaveTypeDef *wave) {
+    if (!wave) {
+        return 0;
+    }
+    return wave->underruns;
+}
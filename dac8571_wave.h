@@ -0,0 +1,107 @@
+/*
+ * @file    dac8571_wave.h
+ * @author  lekhnitsky
+ * @brief   Timer-paced waveform player for I2C 16-bit DAC DAC8571.
+ * @date    2025-01-17
+ */
+
+#ifndef INC_DAC8571_WAVE_H_
+#define INC_DAC8571_WAVE_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "dac8571.h"
+
+/**
+ * @brief Waveform player states.
+ */
+#define DAC8571_WAVE_STOPPED        0x00 ///< Timer stopped
+#define DAC8571_WAVE_RUNNING        0x01 ///< Playing samples
+#define DAC8571_WAVE_UNDERRUN       0x02 ///< Holding output, next half not refilled yet
+
+#define DAC8571_WAVE_MAX_HALF_LENGTH 32767U ///< Largest half, so the ring index stays within 16 bits
+
+/**
+ * @brief Waveform player: a timer paces one sample per period out of a ping-pong ring.
+ * @details The ring holds 2 * halfLength samples. While one half plays, the application
+ *          refills the other from HalfCpltCallback and hands it back with DAC8571_Wave_HalfReady().
+ */
+typedef struct __DAC8571_WaveTypeDef {
+    DAC8571_HandleTypeDef *hdac8571; ///< DAC the samples are written to
+    TIM_HandleTypeDef *htim;         ///< Timer pacing the sample rate
+    uint16_t *ring;                  ///< Sample ring (2 * halfLength values)
+    uint16_t halfLength;             ///< Samples per half
+    volatile uint16_t position;      ///< Index of the next sample in the ring
+    volatile uint8_t halfReady[2];   ///< Half filled by the application and not yet played
+    volatile uint8_t state;          ///< Player state
+    volatile uint32_t samplesPlayed; ///< Samples written since start
+    volatile uint32_t underruns;     ///< Times playback reached a half that was not refilled
+    volatile uint32_t missedTicks;   ///< Timer periods skipped because the previous transfer was still in flight
+    void (*HalfCpltCallback)(struct __DAC8571_WaveTypeDef *wave, uint16_t *half); ///< A half finished playing and can be refilled
+    void (*UnderrunCallback)(struct __DAC8571_WaveTypeDef *wave);                 ///< Playback stalled on an unfilled half
+} DAC8571_WaveTypeDef;
+
+/**
+ * @brief Initialize a waveform player.
+ * @param wave Pointer to the player structure.
+ * @param hdac8571 Pointer to an initialized DAC8571 handle.
+ * @param htim Pointer to a timer configured for the desired sample rate.
+ * @param ring Sample buffer of 2 * halfLength values, both halves filled before start.
+ * @param halfLength Number of samples per half (1 to DAC8571_WAVE_MAX_HALF_LENGTH).
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Wave_Init(DAC8571_WaveTypeDef *wave, DAC8571_HandleTypeDef *hdac8571,
+                                    TIM_HandleTypeDef *htim, uint16_t *ring, uint16_t halfLength);
+
+/**
+ * @brief Start playback from the beginning of the ring.
+ * @param wave Pointer to the player structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Wave_Start(DAC8571_WaveTypeDef *wave);
+
+/**
+ * @brief Stop playback; the DAC keeps its last output value.
+ * @param wave Pointer to the player structure.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Wave_Stop(DAC8571_WaveTypeDef *wave);
+
+/**
+ * @brief Mark a half as refilled.
+ * @param wave Pointer to the player structure.
+ * @param half Pointer passed to HalfCpltCallback.
+ * @return HAL status of the operation.
+ */
+HAL_StatusTypeDef DAC8571_Wave_HalfReady(DAC8571_WaveTypeDef *wave, uint16_t *half);
+
+/**
+ * @brief Advance playback by one sample; call from HAL_TIM_PeriodElapsedCallback.
+ * @param wave Pointer to the player structure.
+ * @param htim Timer that elapsed (ignored if it is not the player's timer).
+ */
+void DAC8571_Wave_TimerHandler(DAC8571_WaveTypeDef *wave, TIM_HandleTypeDef *htim);
+
+/**
+ * @brief Get the current player state.
+ * @param wave Pointer to the player structure.
+ * @return DAC8571_WAVE_STOPPED, DAC8571_WAVE_RUNNING or DAC8571_WAVE_UNDERRUN.
+ */
+uint8_t DAC8571_Wave_GetState(DAC8571_WaveTypeDef *wave);
+
+/**
+ * @brief Get the number of underruns since start.
+ * @param wave Pointer to the player structure.
+ * @return Underrun count.
+ */
+uint32_t DAC8571_Wave_GetUnderruns(DAC8571_WaveTypeDef *wave);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* INC_DAC8571_WAVE_H_ */
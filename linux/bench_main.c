@@ -0,0 +1,148 @@
+/*
+ * @file    bench_main.c
+ * @author  lekhnitsky
+ * @brief   Linux i2c-dev benchmark: samples per second and I2C_RDWR syscalls per sample
+ *          for per-sample writes, bursts and batched multi-device sessions.
+ * @date    2025-01-17
+ */
+
+#include "dac8571.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef HAL_LINUX_LOOPBACK
+#include "dac8571_model.h"
+#endif
+
+typedef HAL_StatusTypeDef (*BenchFn)(DAC8571_HandleTypeDef **dacs, uint8_t count, const uint16_t *pattern, uint32_t samples);
+
+static uint16_t pattern[DAC8571_STREAM_MAX_SAMPLES];
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* One transaction (one ioctl) per sample, round-robin over the devices */
+static HAL_StatusTypeDef BenchWrite(DAC8571_HandleTypeDef **dacs, uint8_t count, const uint16_t *values, uint32_t samples) {
+    for (uint32_t i = 0; i < samples; i++) {
+        HAL_StatusTypeDef status = DAC8571_Write(dacs[i % count], values[i % DAC8571_STREAM_MAX_SAMPLES]);
+        if (status != HAL_OK) {
+            return status;
+        }
+    }
+    return HAL_OK;
+}
+
+/* DAC8571_STREAM_MAX_SAMPLES samples per transaction */
+static HAL_StatusTypeDef BenchStream(DAC8571_HandleTypeDef **dacs, uint8_t count, const uint16_t *values, uint32_t samples) {
+    for (uint32_t sent = 0, i = 0; sent < samples; i++) {
+        uint16_t n = (samples - sent > DAC8571_STREAM_MAX_SAMPLES) ? DAC8571_STREAM_MAX_SAMPLES : (uint16_t)(samples - sent);
+        HAL_StatusTypeDef status = DAC8571_WriteStream(dacs[i % count], values, n);
+        if (status != HAL_OK) {
+            return status;
+        }
+        sent += n;
+    }
+    return HAL_OK;
+}
+
+/* One sample per device per session: every update of a control cycle in a single ioctl */
+static HAL_StatusTypeDef BenchSession(DAC8571_HandleTypeDef **dacs, uint8_t count, const uint16_t *values, uint32_t samples) {
+    DAC8571_SessionTypeDef session;
+    for (uint32_t i = 0; i < samples; i += count) {
+        DAC8571_Session_Begin(&session, dacs[0]->hi2c);
+        for (uint8_t d = 0; d < count; d++) {
+            DAC8571_Session_Write(&session, dacs[d], values[(i + d) % DAC8571_STREAM_MAX_SAMPLES]);
+        }
+        HAL_StatusTypeDef status = DAC8571_Session_End(&session);
+        if (status != HAL_OK) {
+            return status;
+        }
+    }
+    return HAL_OK;
+}
+
+/* Bursts to every device in one session: one ioctl per round */
+static HAL_StatusTypeDef BenchSessionStream(DAC8571_HandleTypeDef **dacs, uint8_t count, const uint16_t *values, uint32_t samples) {
+    DAC8571_SessionTypeDef session;
+    uint32_t perRound = (uint32_t)count * DAC8571_STREAM_MAX_SAMPLES;
+    for (uint32_t i = 0; i < samples; i += perRound) {
+        DAC8571_Session_Begin(&session, dacs[0]->hi2c);
+        for (uint8_t d = 0; d < count; d++) {
+            DAC8571_Session_WriteStream(&session, dacs[d], values, DAC8571_STREAM_MAX_SAMPLES);
+        }
+        HAL_StatusTypeDef status = DAC8571_Session_End(&session);
+        if (status != HAL_OK) {
+            return status;
+        }
+    }
+    return HAL_OK;
+}
+
+static void Run(const char *name, BenchFn fn, I2C_HandleTypeDef *hi2c, DAC8571_HandleTypeDef **dacs, uint8_t count, uint32_t samples) {
+    uint32_t syscalls = hi2c->Syscalls;
+    uint32_t messages = hi2c->Messages;
+    double start = NowSeconds();
+    HAL_StatusTypeDef status = fn(dacs, count, pattern, samples);
+    double elapsed = NowSeconds() - start;
+
+    if (status != HAL_OK) {
+        printf("%-16s [FAILED] %s\r\n", name, HAL_StatusToString(status));
+        return;
+    }
+    syscalls = hi2c->Syscalls - syscalls;
+    messages = hi2c->Messages - messages;
+    printf("%-16s %10.0f samples/s  %8.4f syscalls/sample  %6.2f msgs/syscall\r\n", name,
+           samples / elapsed, (double)syscalls / samples, syscalls ? (double)messages / syscalls : 0.0);
+}
+
+int main(int argc, char **argv) {
+    I2C_HandleTypeDef hi2c = {0};
+    hi2c.Device = (argc > 1) ? argv[1] : "/dev/i2c-1";
+    hi2c.Init.ClockSpeed = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 400000U;
+    uint32_t samples = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 4096U;
+
+    for (uint16_t i = 0; i < DAC8571_STREAM_MAX_SAMPLES; i++) {
+        pattern[i] = (uint16_t)(i * (65535u / DAC8571_STREAM_MAX_SAMPLES));
+    }
+
+#ifdef HAL_LINUX_LOOPBACK
+    SIM_DAC8571_Attach(&hi2c, 0x4C);
+    SIM_DAC8571_Attach(&hi2c, 0x4E);
+    printf("Adapter: in-process loopback (DAC8571 models at 0x4C, 0x4E)\r\n");
+#else
+    printf("Adapter: %s\r\n", hi2c.Device);
+#endif
+    if (HAL_I2C_Init(&hi2c) != HAL_OK) {
+        printf("Cannot open %s\r\n", hi2c.Device);
+        return 1;
+    }
+
+    DAC8571_HandleTypeDef dac[2] = {0};
+    DAC8571_HandleTypeDef *dacs[2];
+    uint8_t count = 0;
+    const uint8_t addresses[2] = {0x4C, 0x4E};
+    for (uint8_t i = 0; i < 2; i++) {
+        DAC8571_Init(&dac[i], &hi2c, addresses[i]);
+        if (DAC8571_GetInitState(&dac[i]) == DAC8571_INIT_READY) {
+            dacs[count++] = &dac[i];
+            printf("DAC8571 at 0x%02X\r\n", addresses[i]);
+        }
+    }
+    if (count == 0) {
+        printf("No DAC8571 found\r\n");
+        return 1;
+    }
+
+    printf("Samples: %lu across %u device(s)\r\n", (unsigned long)samples, count);
+    Run("Write", BenchWrite, &hi2c, dacs, count, samples);
+    Run("WriteStream", BenchStream, &hi2c, dacs, count, samples);
+    Run("Session", BenchSession, &hi2c, dacs, count, samples);
+    Run("Session stream", BenchSessionStream, &hi2c, dacs, count, samples);
+
+    HAL_I2C_DeInit(&hi2c);
+    return 0;
+}
@@ -0,0 +1,321 @@
+/*
+ * @file    hal_linux.c
+ * @author  lekhnitsky
+ * @brief   Linux i2c-dev stand-in for the STM32F4 HAL I2C surface.
+ *          Every transfer is an I2C_RDWR ioctl. Sequential frames (HAL_I2C_Master_Seq_Transmit_IT
+ *          without a STOP) are queued and sent as one multi-message ioctl when the STOP is due
+ *          (a last-frame option, or I2C_CR1_STOP set and the BUSY flag polled, as on the F4),
+ *          so a DAC8571 session costs one syscall however many devices and frames it spans.
+ *          Build with -DHAL_LINUX_LOOPBACK to serve the messages from the simulator's DAC8571
+ *          model instead of an adapter.
+ * @date    2025-01-17
+ */
+
+#include "stm32f4xx_hal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#ifdef HAL_LINUX_LOOPBACK
+#include "dac8571_model.h"
+#endif
+
+__attribute__((weak)) void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) { (void)hi2c; }
+__attribute__((weak)) void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) { (void)hi2c; }
+__attribute__((weak)) void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c) { (void)hi2c; }
+
+static int Transfer(I2C_HandleTypeDef *hi2c, struct i2c_msg *msgs, uint32_t count) {
+    hi2c->Syscalls++;
+    hi2c->Messages += count;
+#ifdef HAL_LINUX_LOOPBACK
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t address = (uint8_t)msgs[i].addr;
+        int ack;
+        if (msgs[i].flags & I2C_M_RD) {
+            ack = SIM_DAC8571_Read(hi2c, address, msgs[i].buf, msgs[i].len);
+        } else if (msgs[i].len == 0) {
+            ack = SIM_DAC8571_Probe(hi2c, address);
+        } else {
+            ack = SIM_DAC8571_Write(hi2c, address, msgs[i].buf, msgs[i].len, 0);
+        }
+        if (ack != 0) {
+            errno = ENXIO;
+            return -1;
+        }
+    }
+    return (int)count;
+#else
+    struct i2c_rdwr_ioctl_data data = {msgs, count};
+    return ioctl(hi2c->Fd, I2C_RDWR, &data);
+#endif
+}
+
+/* Maps an ioctl failure onto the HAL error model */
+static HAL_StatusTypeDef Fail(I2C_HandleTypeDef *hi2c) {
+    if (errno == ETIMEDOUT) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_TIMEOUT;
+    }
+    // ENXIO / EREMOTEIO: address or data byte not acknowledged
+    hi2c->ErrorCode = (errno == ENXIO || errno == EREMOTEIO) ? HAL_I2C_ERROR_AF : HAL_I2C_ERROR_BERR;
+    return HAL_ERROR;
+}
+
+static void SetTimeout(I2C_HandleTypeDef *hi2c, uint32_t Timeout) {
+#ifndef HAL_LINUX_LOOPBACK
+    if (Timeout != hi2c->TimeoutMs && Timeout != HAL_MAX_DELAY) {
+        // I2C_TIMEOUT is in units of 10 ms
+        ioctl(hi2c->Fd, I2C_TIMEOUT, (unsigned long)((Timeout + 9) / 10));
+        hi2c->TimeoutMs = Timeout;
+    }
+#else
+    (void)hi2c;
+    (void)Timeout;
+#endif
+}
+
+static HAL_StatusTypeDef Acquire(I2C_HandleTypeDef *hi2c) {
+    if (!hi2c || !hi2c->Open) {
+        return HAL_ERROR;
+    }
+    if (hi2c->State != HAL_I2C_STATE_READY) {
+        return HAL_BUSY;
+    }
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    return HAL_OK;
+}
+
+/* Appends one message to the batch; payloads are copied because callers reuse their buffers */
+static HAL_StatusTypeDef Queue(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t flags, uint8_t *pData, uint16_t Size) {
+    if (Size > I2C_LINUX_BATCH_BYTES) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_BERR;
+        return HAL_ERROR;
+    }
+    if (hi2c->NumMsgs == I2C_LINUX_MAX_MSGS || hi2c->BufUsed + Size > I2C_LINUX_BATCH_BYTES) {
+        // Batch full: send it (this puts a STOP between the two halves of the sequence)
+        struct i2c_msg *msgs = hi2c->Msgs;
+        uint16_t count = hi2c->NumMsgs;
+        hi2c->NumMsgs = 0;
+        hi2c->BufUsed = 0;
+        if (Transfer(hi2c, msgs, count) < 0) {
+            return Fail(hi2c);
+        }
+    }
+
+    struct i2c_msg *msg = &hi2c->Msgs[hi2c->NumMsgs++];
+    msg->addr = (uint16_t)(DevAddress >> 1);
+    msg->flags = flags;
+    msg->len = Size;
+    msg->buf = &hi2c->Buf[hi2c->BufUsed];
+    if (!(flags & I2C_M_RD) && Size > 0) {
+        memcpy(msg->buf, pData, Size);
+    }
+    hi2c->BufUsed += Size;
+    return HAL_OK;
+}
+
+/* Sends the batch, ending with a STOP; read payloads are copied back to pRead */
+static HAL_StatusTypeDef Flush(I2C_HandleTypeDef *hi2c, uint8_t *pRead) {
+    uint16_t count = hi2c->NumMsgs;
+    hi2c->NumMsgs = 0;
+    hi2c->BufUsed = 0;
+    if (count == 0) {
+        return HAL_OK;
+    }
+    if (Transfer(hi2c, hi2c->Msgs, count) < 0) {
+        return Fail(hi2c);
+    }
+    struct i2c_msg *last = &hi2c->Msgs[count - 1];
+    if (pRead && (last->flags & I2C_M_RD)) {
+        memcpy(pRead, last->buf, last->len);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c) {
+    if (!hi2c) {
+        return HAL_ERROR;
+    }
+    if (!hi2c->Open) {
+#ifdef HAL_LINUX_LOOPBACK
+        hi2c->Fd = -1;
+#else
+        if (!hi2c->Device) {
+            return HAL_ERROR;
+        }
+        hi2c->Fd = open(hi2c->Device, O_RDWR);
+        if (hi2c->Fd < 0) {
+            return HAL_ERROR;
+        }
+#endif
+        hi2c->Open = 1;
+        hi2c->TimeoutMs = 0;
+    }
+    hi2c->Instance = &hi2c->Regs;
+    hi2c->Regs.CR1 = 0;
+    hi2c->NumMsgs = 0;
+    hi2c->BufUsed = 0;
+    hi2c->Flags = 0;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c) {
+    if (!hi2c) {
+        return HAL_ERROR;
+    }
+    if (hi2c->Open && hi2c->Fd >= 0) {
+        close(hi2c->Fd);
+    }
+    hi2c->Open = 0;
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    HAL_StatusTypeDef status = Acquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+    SetTimeout(hi2c, Timeout);
+
+    // Joins a pending sequence (repeated START) and ends it with the STOP
+    status = Queue(hi2c, DevAddress, 0, pData, Size);
+    return (status == HAL_OK) ? Flush(hi2c, NULL) : status;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    HAL_StatusTypeDef status = Acquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+    SetTimeout(hi2c, Timeout);
+
+    status = Queue(hi2c, DevAddress, I2C_M_RD, pData, Size);
+    return (status == HAL_OK) ? Flush(hi2c, pData) : status;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout) {
+    HAL_StatusTypeDef status = Acquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+    SetTimeout(hi2c, Timeout);
+
+    status = Flush(hi2c, NULL);
+    for (uint32_t trial = 0; trial < Trials && status == HAL_OK; trial++) {
+        // Zero-length write: address byte only
+        struct i2c_msg probe = {(uint16_t)(DevAddress >> 1), 0, 0, hi2c->Buf};
+        if (Transfer(hi2c, &probe, 1) >= 0) {
+            return HAL_OK;
+        }
+        if (Fail(hi2c) == HAL_TIMEOUT) {
+            return HAL_TIMEOUT;
+        }
+    }
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size) {
+    HAL_StatusTypeDef status = Acquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // No DMA from user space: the transfer completes before the call returns
+    status = Queue(hi2c, DevAddress, 0, pData, Size);
+    if (status == HAL_OK) {
+        status = Flush(hi2c, NULL);
+    }
+    if (status == HAL_OK) {
+        HAL_I2C_MasterTxCpltCallback(hi2c);
+    } else {
+        HAL_I2C_ErrorCallback(hi2c);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions) {
+    HAL_StatusTypeDef status = Acquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+    if ((DevAddress & 0xF8U) == 0x08U) {
+        // High-speed master codes cannot be expressed through i2c-dev
+        return HAL_ERROR;
+    }
+
+    status = Queue(hi2c, DevAddress, 0, pData, Size);
+    if (status == HAL_OK && (XferOptions == I2C_FIRST_AND_LAST_FRAME || XferOptions == I2C_LAST_FRAME ||
+                             XferOptions == I2C_OTHER_AND_LAST_FRAME)) {
+        status = Flush(hi2c, NULL);
+    }
+
+    // Frames without a STOP are only queued; their errors surface when the sequence is sent
+    if (status == HAL_OK) {
+        HAL_I2C_MasterTxCpltCallback(hi2c);
+    } else {
+        HAL_I2C_ErrorCallback(hi2c);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress) {
+    (void)hi2c;
+    (void)DevAddress;
+    // Every call completes before it returns, so there is never a master transfer to abort
+    return HAL_ERROR;
+}
+
+uint8_t I2C_LINUX_GetFlag(I2C_HandleTypeDef *hi2c, uint32_t flag) {
+    if (hi2c->Regs.CR1 & I2C_CR1_STOP) {
+        // The STOP: send the queued sequence as one ioctl; a failure lands in ErrorCode
+        hi2c->Regs.CR1 &= ~I2C_CR1_STOP;
+        hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+        if (hi2c->Open) {
+            Flush(hi2c, NULL);
+        }
+    }
+    return (hi2c->Flags & flag) == flag;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c) {
+    return hi2c->State;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c) {
+    return hi2c->ErrorCode;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+    (void)GPIOx;
+    (void)GPIO_Init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    (void)GPIOx;
+    (void)GPIO_Pin;
+    (void)PinState;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    (void)GPIOx;
+    (void)GPIO_Pin;
+    return GPIO_PIN_SET;
+}
+
+void HAL_Delay(uint32_t Delay) {
+    struct timespec ts = {(time_t)(Delay / 1000U), (long)(Delay % 1000U) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+uint32_t HAL_GetTick(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U);
+}
@@ -0,0 +1,176 @@
+/*
+ * @file    stm32f4xx_hal.h
+ * @author  lekhnitsky
+ * @brief   Linux i2c-dev stand-in for the STM32F4 HAL surface used by the DAC8571 library.
+ *          Transfers become I2C_RDWR ioctls on /dev/i2c-N; sequential frames are batched.
+ * @date    2025-01-17
+ */
+
+#ifndef LINUX_STM32F4XX_HAL_H_
+#define LINUX_STM32F4XX_HAL_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/i2c.h>
+
+#define HAL_LINUX 1 ///< Building against the Linux i2c-dev backend
+
+/**
+ * @brief HAL status structure.
+ */
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY      0xFFFFFFFFU
+
+/**
+ * @brief I2C state structure.
+ */
+typedef enum {
+    HAL_I2C_STATE_RESET   = 0x00U,
+    HAL_I2C_STATE_READY   = 0x20U,
+    HAL_I2C_STATE_BUSY    = 0x24U,
+    HAL_I2C_STATE_BUSY_TX = 0x21U,
+    HAL_I2C_STATE_BUSY_RX = 0x22U,
+    HAL_I2C_STATE_ABORT   = 0x60U,
+    HAL_I2C_STATE_ERROR   = 0xE0U
+} HAL_I2C_StateTypeDef;
+
+#define HAL_I2C_ERROR_NONE      0x00000000U ///< No error
+#define HAL_I2C_ERROR_BERR      0x00000001U ///< Bus error
+#define HAL_I2C_ERROR_AF        0x00000004U ///< Acknowledge failure
+#define HAL_I2C_ERROR_TIMEOUT   0x00000020U ///< Timeout error
+
+#define I2C_FLAG_BUSY           0x00100002U ///< Bus busy flag
+#define I2C_CR1_STOP            0x00000200U ///< Generate a STOP after the current byte
+
+#define SET_BIT(REG, BIT)       ((REG) |= (BIT))
+
+/* Sequential transfer options (HAL_I2C_Master_Seq_Transmit_IT) */
+#define I2C_FIRST_FRAME             0x00000001U ///< START, no STOP
+#define I2C_FIRST_AND_NEXT_FRAME    0x00000002U
+#define I2C_NEXT_FRAME              0x00000004U ///< Repeated START, no STOP
+#define I2C_FIRST_AND_LAST_FRAME    0x00000008U ///< START and STOP
+#define I2C_LAST_FRAME_NO_STOP      0x00000010U
+#define I2C_LAST_FRAME              0x00000020U ///< Repeated START, then STOP
+#define I2C_OTHER_FRAME             0x00AA0000U
+#define I2C_OTHER_AND_LAST_FRAME    0xAA000000U
+
+#define I2C_LINUX_MAX_MSGS      42   ///< I2C_RDWR_IOCTL_MAX_MSGS: messages per ioctl
+#define I2C_LINUX_BATCH_BYTES   1024 ///< Payload bytes buffered for one ioctl
+
+/**
+ * @brief GPIO port and configuration structures (subset, no-ops: the kernel owns the pins).
+ */
+typedef struct {
+    uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_MODE_INPUT          0x00000000U
+#define GPIO_MODE_OUTPUT_OD      0x00000011U
+#define GPIO_MODE_AF_OD          0x00000012U
+#define GPIO_NOPULL              0x00000000U
+#define GPIO_SPEED_FREQ_HIGH     0x00000002U
+
+/**
+ * @brief I2C peripheral registers (subset).
+ */
+typedef struct {
+    volatile uint32_t CR1;
+} I2C_TypeDef;
+
+/**
+ * @brief I2C configuration structure (subset).
+ */
+typedef struct {
+    uint32_t ClockSpeed;     ///< SCL frequency in Hz, set by the kernel; used to derive timeouts
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+} I2C_InitTypeDef;
+
+/**
+ * @brief I2C handle structure (subset plus i2c-dev state).
+ */
+typedef struct __I2C_HandleTypeDef {
+    I2C_TypeDef *Instance;    ///< Points at Regs after HAL_I2C_Init
+    I2C_InitTypeDef Init;
+    volatile HAL_I2C_StateTypeDef State;
+    volatile uint32_t ErrorCode;
+
+    const char *Device;       ///< Adapter device node, e.g. "/dev/i2c-1" (opened by HAL_I2C_Init)
+    int Fd;                   ///< Open file descriptor of Device
+    uint8_t Open;             ///< Fd is valid
+    I2C_TypeDef Regs;         ///< Register stand-in: a STOP set in CR1 sends the batch
+    uint32_t Flags;           ///< Status flags (I2C_FLAG_*)
+    uint32_t TimeoutMs;       ///< Adapter timeout last set with I2C_TIMEOUT
+
+    struct i2c_msg Msgs[I2C_LINUX_MAX_MSGS]; ///< Sequential frames waiting for the STOP
+    uint8_t Buf[I2C_LINUX_BATCH_BYTES];      ///< Copies of the batched payloads
+    uint16_t NumMsgs;         ///< Frames in Msgs
+    uint16_t BufUsed;         ///< Bytes used in Buf
+
+    uint32_t Syscalls;        ///< I2C_RDWR ioctls issued
+    uint32_t Messages;        ///< i2c_msg entries transferred
+} I2C_HandleTypeDef;
+
+#define __HAL_I2C_GET_FLAG(__HANDLE__, __FLAG__)   I2C_LINUX_GetFlag((__HANDLE__), (__FLAG__))
+#define __HAL_I2C_CLEAR_FLAG(__HANDLE__, __FLAG__) ((__HANDLE__)->Flags &= ~(__FLAG__))
+
+/**
+ * @brief Status flag read; a STOP requested through CR1 sends the batched sequence first.
+ * @param hi2c Pointer to the I2C handle.
+ * @param flag Flag to test (I2C_FLAG_*).
+ * @return 1 if the flag is set.
+ */
+uint8_t I2C_LINUX_GetFlag(I2C_HandleTypeDef *hi2c, uint32_t flag);
+
+/* HAL API subset */
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions);
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c);
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+void HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* LINUX_STM32F4XX_HAL_H_ */
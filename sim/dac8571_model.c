@@ -0,0 +1,140 @@
+/*
+ * @file    dac8571_model.c
+ * @author  lekhnitsky
+ * @brief   Behavioral model of the DAC8571 for the host HAL simulator.
+ * @date    2025-01-17
+ */
+
+#include "dac8571_model.h"
+#include <string.h>
+
+/* Control byte fields (datasheet): L1 L0 select the load mode, PD0 requests power-down */
+#define CTRL_LOAD_MASK      0x30
+#define CTRL_LOAD_TMP       0x00 ///< Store in temporary register
+#define CTRL_LOAD_UPDATE    0x10 ///< Store and update DAC register
+#define CTRL_LOAD_FROM_TMP  0x20 ///< Update DAC register from temporary register
+#define CTRL_LOAD_BROADCAST 0x30 ///< Broadcast update
+#define CTRL_PD0            0x01
+
+static SIM_DAC8571TypeDef devices[SIM_DAC8571_MAX_DEVICES];
+static uint8_t deviceCount;
+
+SIM_DAC8571TypeDef *SIM_DAC8571_Attach(I2C_HandleTypeDef *hi2c, uint8_t address) {
+    if (deviceCount >= SIM_DAC8571_MAX_DEVICES) {
+        return NULL;
+    }
+    SIM_DAC8571TypeDef *dev = &devices[deviceCount++];
+    memset(dev, 0, sizeof(*dev));
+    dev->hi2c = hi2c;
+    dev->address = address;
+    return dev;
+}
+
+SIM_DAC8571TypeDef *SIM_DAC8571_Find(I2C_HandleTypeDef *hi2c, uint8_t address) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i].hi2c == hi2c && devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+void SIM_DAC8571_DetachAll(void) {
+    deviceCount = 0;
+}
+
+static void UpdateDac(SIM_DAC8571TypeDef *dev, uint16_t value, uint64_t nowNs) {
+    dev->dacReg = value;
+    dev->powerDown = 0;
+    dev->updates++;
+    dev->lastUpdateNs = nowNs;
+}
+
+static void ApplyPair(SIM_DAC8571TypeDef *dev, uint8_t control, uint16_t data, uint64_t nowNs) {
+    uint8_t load = control & CTRL_LOAD_MASK;
+
+    if (control & CTRL_PD0) {
+        // Power-down: PD2..PD0 are carried in the three MSBs of the data word
+        dev->powerDown = (uint8_t)((data >> 13) | 0x01);
+        return;
+    }
+
+    switch (load) {
+        case CTRL_LOAD_TMP:
+            dev->tempReg = data;
+            break;
+        case CTRL_LOAD_UPDATE:
+            dev->tempReg = data;
+            UpdateDac(dev, data, nowNs);
+            break;
+        case CTRL_LOAD_FROM_TMP:
+        case CTRL_LOAD_BROADCAST:
+            UpdateDac(dev, dev->tempReg, nowNs);
+            break;
+    }
+}
+
+int SIM_DAC8571_Write(I2C_HandleTypeDef *hi2c, uint8_t address, const uint8_t *data, uint16_t size, uint64_t startNs) {
+    uint32_t clock = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+    uint64_t bitNs = 1000000000ULL / clock;
+
+    if (address == SIM_DAC8571_BROADCAST_ADDR) {
+        // Every device on the bus latches on the same edge
+        uint64_t latchNs = startNs + bitNs * (1 + 9 * (uint64_t)(size + 1));
+        for (uint8_t i = 0; i < deviceCount; i++) {
+            SIM_DAC8571TypeDef *dev = &devices[i];
+            if (dev->hi2c != hi2c || dev->nack) {
+                continue;
+            }
+            dev->transactions++;
+            dev->bytes += size;
+            if (size >= 1) {
+                dev->control = data[0];
+                if ((data[0] & CTRL_LOAD_MASK) == CTRL_LOAD_BROADCAST) {
+                    uint16_t word = (size >= 3) ? (uint16_t)((data[1] << 8) | data[2]) : 0;
+                    ApplyPair(dev, data[0], word, latchNs);
+                }
+            }
+        }
+        return 0;
+    }
+
+    SIM_DAC8571TypeDef *dev = SIM_DAC8571_Find(hi2c, address);
+    if (!dev || dev->nack) {
+        return -1;
+    }
+
+    dev->transactions++;
+    dev->bytes += size;
+    if (size == 0) {
+        return 0;
+    }
+
+    // Control byte once, then any number of MSB/LSB pairs; each pair acts on its LSB ACK
+    dev->control = data[0];
+    for (uint16_t i = 1; i + 1 < size; i += 2) {
+        uint16_t word = (uint16_t)((data[i] << 8) | data[i + 1]);
+        uint64_t ackNs = startNs + bitNs * (1 + 9 * (uint64_t)(i + 2));
+        ApplyPair(dev, data[0], word, ackNs);
+    }
+    return 0;
+}
+
+int SIM_DAC8571_Read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t *data, uint16_t size) {
+    SIM_DAC8571TypeDef *dev = SIM_DAC8571_Find(hi2c, address);
+    if (!dev || dev->nack) {
+        return -1;
+    }
+
+    uint8_t frame[3] = {(uint8_t)(dev->tempReg >> 8), (uint8_t)(dev->tempReg & 0xFF), dev->control};
+    for (uint16_t i = 0; i < size; i++) {
+        data[i] = frame[i % 3];
+    }
+    dev->transactions++;
+    return 0;
+}
+
+int SIM_DAC8571_Probe(I2C_HandleTypeDef *hi2c, uint8_t address) {
+    SIM_DAC8571TypeDef *dev = SIM_DAC8571_Find(hi2c, address);
+    return (dev && !dev->nack) ? 0 : -1;
+}
@@ -0,0 +1,87 @@
+/*
+ * @file    dac8571_model.h
+ * @author  lekhnitsky
+ * @brief   Behavioral model of the DAC8571 for the host HAL simulator.
+ * @date    2025-01-17
+ */
+
+#ifndef SIM_DAC8571_MODEL_H_
+#define SIM_DAC8571_MODEL_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stm32f4xx_hal.h> /* from the include path: the simulator or the Linux i2c-dev stand-in */
+
+#define SIM_DAC8571_MAX_DEVICES     8    ///< Device models across all simulated buses
+#define SIM_DAC8571_BROADCAST_ADDR  0x48 ///< 7-bit broadcast address
+
+/**
+ * @brief State of one simulated DAC8571.
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;  ///< Bus the device sits on
+    uint8_t address;          ///< 7-bit address (0x4C or 0x4E)
+    uint8_t nack;             ///< Fault injection: NACK every address byte
+    uint8_t control;          ///< Last control byte received
+    uint16_t tempReg;         ///< Temporary (input) register
+    uint16_t dacReg;          ///< DAC register driving the output
+    uint8_t powerDown;        ///< Power-down bits PD2..PD0 (0 = normal operation)
+    uint32_t transactions;    ///< Write/read transactions addressed to the device
+    uint32_t bytes;           ///< Bytes received after the address byte
+    uint32_t updates;         ///< DAC register updates (output changes)
+    uint64_t lastUpdateNs;    ///< Virtual time of the last DAC register update
+} SIM_DAC8571TypeDef;
+
+/**
+ * @brief Attach a device model to a simulated bus.
+ * @param hi2c Pointer to the I2C handle.
+ * @param address 7-bit device address.
+ * @return Pointer to the model, or NULL when SIM_DAC8571_MAX_DEVICES is reached.
+ */
+SIM_DAC8571TypeDef *SIM_DAC8571_Attach(I2C_HandleTypeDef *hi2c, uint8_t address);
+
+/**
+ * @brief Find the device model at an address.
+ * @param hi2c Pointer to the I2C handle.
+ * @param address 7-bit device address.
+ * @return Pointer to the model, or NULL if none is attached.
+ */
+SIM_DAC8571TypeDef *SIM_DAC8571_Find(I2C_HandleTypeDef *hi2c, uint8_t address);
+
+/**
+ * @brief Detach all device models.
+ */
+void SIM_DAC8571_DetachAll(void);
+
+/**
+ * @brief Deliver a write transaction to the model(s).
+ * @param hi2c Pointer to the I2C handle.
+ * @param address 7-bit address from the address byte.
+ * @param data Bytes following the address byte.
+ * @param size Number of bytes.
+ * @param startNs Virtual time of the START condition.
+ * @return 0 if the address was acknowledged, -1 on NACK.
+ */
+int SIM_DAC8571_Write(I2C_HandleTypeDef *hi2c, uint8_t address, const uint8_t *data, uint16_t size, uint64_t startNs);
+
+/**
+ * @brief Serve a read transaction (MSB, LSB, control byte of the temporary register).
+ * @return 0 if the address was acknowledged, -1 on NACK.
+ */
+int SIM_DAC8571_Read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t *data, uint16_t size);
+
+/**
+ * @brief Address-only probe.
+ * @return 0 if the address was acknowledged, -1 on NACK.
+ */
+int SIM_DAC8571_Probe(I2C_HandleTypeDef *hi2c, uint8_t address);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* SIM_DAC8571_MODEL_H_ */
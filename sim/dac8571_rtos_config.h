@@ -0,0 +1,17 @@
+/*
+ * @file    dac8571_rtos_config.h
+ * @author  lekhnitsky
+ * @brief   DAC8571 bus mutex hooks mapped onto the simulator's counting mutex.
+ * @date    2025-01-17
+ *
+ * make -C sim CFLAGS="-O2 -DDAC8571_ENABLE_LOCKING -DDAC8571_CONFIG_FILE='\"dac8571_rtos_config.h\"'"
+ */
+
+#ifndef SIM_DAC8571_RTOS_CONFIG_H_
+#define SIM_DAC8571_RTOS_CONFIG_H_
+
+#define DAC8571_BUS_MUTEX_NEW()         SIM_MutexNew()
+#define DAC8571_BUS_LOCK(mutex, ms)     SIM_MutexAcquire((mutex), (ms))
+#define DAC8571_BUS_UNLOCK(mutex)       SIM_MutexRelease(mutex)
+
+#endif /* SIM_DAC8571_RTOS_CONFIG_H_ */
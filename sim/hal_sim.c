@@ -0,0 +1,485 @@
+/*
+ * @file    hal_sim.c
+ * @author  lekhnitsky
+ * @brief   Host stand-in for the STM32F4 HAL I2C/timer surface, driven by a virtual clock.
+ * @date    2025-01-17
+ */
+
+#include "stm32f4xx_hal.h"
+#include "dac8571_model.h"
+
+#define SIM_MAX_BUSES       4
+#define SIM_MAX_TIMERS      4
+#define SIM_MAX_MUTEXES     4
+#define SIM_CPU_NS_PER_POLL 1000U ///< Virtual CPU time charged per HAL_GetTick() call
+
+static uint64_t simNowNs;
+static I2C_HandleTypeDef *simBuses[SIM_MAX_BUSES];
+static TIM_HandleTypeDef *simTimers[SIM_MAX_TIMERS];
+static SIM_MutexTypeDef simMutexes[SIM_MAX_MUTEXES];
+static uint8_t simMutexCount;
+
+__attribute__((weak)) void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) { (void)hi2c; }
+__attribute__((weak)) void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) { (void)hi2c; }
+__attribute__((weak)) void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c) { (void)hi2c; }
+__attribute__((weak)) void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) { (void)htim; }
+
+static void TrackBus(I2C_HandleTypeDef *hi2c) {
+    for (uint8_t i = 0; i < SIM_MAX_BUSES; i++) {
+        if (simBuses[i] == hi2c) {
+            return;
+        }
+        if (simBuses[i] == NULL) {
+            simBuses[i] = hi2c;
+            return;
+        }
+    }
+}
+
+static uint64_t TimerPeriodNs(TIM_HandleTypeDef *htim) {
+    uint64_t ticks = (uint64_t)(htim->Init.Prescaler + 1) * (htim->Init.Period + 1);
+    return ticks * 1000000000ULL / SIM_TIM_CLOCK_HZ;
+}
+
+uint64_t SIM_GetTimeNs(void) {
+    return simNowNs;
+}
+
+uint64_t SIM_TransactionTimeNs(I2C_HandleTypeDef *hi2c, uint16_t size) {
+    uint32_t clock = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+    // START + 9 bits per byte (address included) + STOP, then the bus free time
+    uint64_t bits = 2 + 9 * (uint64_t)(size + 1);
+    uint64_t busFreeNs = (clock > 100000U) ? 1300U : 4700U;
+    return bits * 1000000000ULL / clock + busFreeNs;
+}
+
+void SIM_Advance(uint64_t ns) {
+    uint64_t target = simNowNs + ns;
+
+    for (;;) {
+        // Earliest pending event up to the target time
+        uint64_t next = target;
+        for (uint8_t i = 0; i < SIM_MAX_BUSES; i++) {
+            if (simBuses[i] && simBuses[i]->SimDmaPending && simBuses[i]->SimBusyUntilNs < next) {
+                next = simBuses[i]->SimBusyUntilNs;
+            }
+        }
+        for (uint8_t i = 0; i < SIM_MAX_TIMERS; i++) {
+            if (simTimers[i] && simTimers[i]->SimRunning && simTimers[i]->SimNextNs < next) {
+                next = simTimers[i]->SimNextNs;
+            }
+        }
+        if (next > simNowNs) {
+            simNowNs = next;
+        }
+
+        uint8_t fired = 0;
+        for (uint8_t i = 0; i < SIM_MAX_BUSES; i++) {
+            I2C_HandleTypeDef *hi2c = simBuses[i];
+            if (hi2c && hi2c->SimDmaPending && hi2c->SimBusyUntilNs <= simNowNs) {
+                hi2c->SimDmaPending = 0;
+                hi2c->State = HAL_I2C_STATE_READY;
+                if (hi2c->SimAbortPending) {
+                    hi2c->SimAbortPending = 0;
+                    HAL_I2C_AbortCpltCallback(hi2c);
+                } else if (hi2c->SimDmaFailed) {
+                    hi2c->ErrorCode = (hi2c->SimDmaFailed == SIM_DMA_TIMEOUT) ? HAL_I2C_ERROR_TIMEOUT : HAL_I2C_ERROR_AF;
+                    HAL_I2C_ErrorCallback(hi2c);
+                } else {
+                    HAL_I2C_MasterTxCpltCallback(hi2c);
+                }
+                fired = 1;
+            }
+        }
+        for (uint8_t i = 0; i < SIM_MAX_TIMERS; i++) {
+            TIM_HandleTypeDef *htim = simTimers[i];
+            if (htim && htim->SimRunning && htim->SimNextNs <= simNowNs) {
+                htim->SimNextNs += TimerPeriodNs(htim);
+                HAL_TIM_PeriodElapsedCallback(htim);
+                fired = 1;
+            }
+        }
+
+        if (!fired && simNowNs >= target) {
+            break;
+        }
+    }
+}
+
+void SIM_Reset(void) {
+    simNowNs = 0;
+    for (uint8_t i = 0; i < SIM_MAX_BUSES; i++) {
+        simBuses[i] = NULL;
+    }
+    for (uint8_t i = 0; i < SIM_MAX_TIMERS; i++) {
+        simTimers[i] = NULL;
+    }
+    SIM_DAC8571_DetachAll();
+}
+
+/* Frames above Fm speed are only legal after a master code put the bus in high-speed mode */
+static void CheckTiming(I2C_HandleTypeDef *hi2c) {
+    uint32_t clock = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+    if ((clock > SIM_I2C_FM_MAX_HZ && !hi2c->SimHsActive) || clock > SIM_I2C_HS_MAX_HZ) {
+        hi2c->SimTimingViolations++;
+    }
+}
+
+static HAL_StatusTypeDef BusAcquire(I2C_HandleTypeDef *hi2c) {
+    if (!hi2c) {
+        return HAL_ERROR;
+    }
+    TrackBus(hi2c);
+    if (!hi2c->Instance) {
+        hi2c->Instance = &hi2c->SimRegs;
+    }
+    if (hi2c->State != HAL_I2C_STATE_READY && hi2c->State != HAL_I2C_STATE_RESET) {
+        return HAL_BUSY;
+    }
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    return HAL_OK;
+}
+
+/* Occupies the bus for a blocking transfer; interrupts may run meanwhile */
+static HAL_StatusTypeDef BusOccupy(I2C_HandleTypeDef *hi2c, uint64_t durationNs, uint32_t Timeout, int ack) {
+    if (hi2c->SimStuck) {
+        hi2c->State = HAL_I2C_STATE_BUSY;
+        hi2c->SimFlags |= I2C_FLAG_BUSY;
+        SIM_Advance((uint64_t)Timeout * 1000000ULL);
+        hi2c->State = HAL_I2C_STATE_READY;
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_TIMEOUT;
+    }
+
+    // Blocking transfers always end with a STOP
+    CheckTiming(hi2c);
+    hi2c->SimInFrame = 0;
+    hi2c->SimHsActive = 0;
+    hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+    hi2c->State = HAL_I2C_STATE_BUSY;
+    hi2c->SimBusyUntilNs = simNowNs + durationNs;
+    SIM_Advance(durationNs);
+    hi2c->State = HAL_I2C_STATE_READY;
+
+    if (ack != 0) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    HAL_StatusTypeDef status = BusAcquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    int ack = hi2c->SimStuck ? 0 : SIM_DAC8571_Write(hi2c, (uint8_t)(DevAddress >> 1), pData, Size, simNowNs);
+    // A NACKed address byte ends the transfer after the first byte
+    uint64_t duration = SIM_TransactionTimeNs(hi2c, (ack == 0) ? Size : 0);
+    return BusOccupy(hi2c, duration, Timeout, ack);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    HAL_StatusTypeDef status = BusAcquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    int ack = hi2c->SimStuck ? 0 : SIM_DAC8571_Read(hi2c, (uint8_t)(DevAddress >> 1), pData, Size);
+    uint64_t duration = SIM_TransactionTimeNs(hi2c, (ack == 0) ? Size : 0);
+    return BusOccupy(hi2c, duration, Timeout, ack);
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout) {
+    HAL_StatusTypeDef status = BusAcquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    for (uint32_t trial = 0; trial < Trials; trial++) {
+        int ack = hi2c->SimStuck ? 0 : SIM_DAC8571_Probe(hi2c, (uint8_t)(DevAddress >> 1));
+        status = BusOccupy(hi2c, SIM_TransactionTimeNs(hi2c, 0), Timeout, ack);
+        if (status == HAL_OK || status == HAL_TIMEOUT) {
+            return status;
+        }
+    }
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size) {
+    HAL_StatusTypeDef status = BusAcquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // Stuck bus: the transfer never gets through and ends in a timeout error interrupt
+    if (hi2c->SimStuck) {
+        hi2c->State = HAL_I2C_STATE_BUSY_TX;
+        hi2c->SimFlags |= I2C_FLAG_BUSY;
+        hi2c->SimDmaFailed = SIM_DMA_TIMEOUT;
+        hi2c->SimDmaPending = 1;
+        hi2c->SimBusyUntilNs = simNowNs + SIM_TransactionTimeNs(hi2c, Size);
+        return HAL_OK;
+    }
+
+    // The model sees the bytes now; the completion interrupt fires when the bus time has elapsed
+    CheckTiming(hi2c);
+    int ack = SIM_DAC8571_Write(hi2c, (uint8_t)(DevAddress >> 1), pData, Size, simNowNs);
+    hi2c->SimInFrame = 0;
+    hi2c->SimHsActive = 0;
+    hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+    hi2c->State = HAL_I2C_STATE_BUSY_TX;
+    hi2c->SimDmaFailed = (ack != 0) ? SIM_DMA_NACK : 0;
+    hi2c->SimDmaPending = 1;
+    hi2c->SimBusyUntilNs = simNowNs + SIM_TransactionTimeNs(hi2c, (ack == 0) ? Size : 0);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions) {
+    HAL_StatusTypeDef status = BusAcquire(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    uint32_t clock = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+    int stop = (XferOptions == I2C_FIRST_AND_LAST_FRAME || XferOptions == I2C_LAST_FRAME ||
+                XferOptions == I2C_OTHER_AND_LAST_FRAME);
+    int ack;
+
+    if ((DevAddress & 0xF8U) == SIM_I2C_MASTER_CODE) {
+        // Master code: sent in F/S mode and acknowledged by nobody
+        if (clock > SIM_I2C_FM_MAX_HZ) {
+            hi2c->SimTimingViolations++;
+        }
+        uint64_t durationNs = (1 + 9) * 1000000000ULL / clock;
+        if (hi2c->SimHsCapable) {
+            // No STOP: the bus is in HS mode until the next one
+            hi2c->SimHsActive = 1;
+            hi2c->SimInFrame = 1;
+            hi2c->SimFlags |= I2C_FLAG_BUSY;
+        } else {
+            // The F4 HAL treats the NACK as an error and sends a STOP, so HS mode never starts
+            durationNs += 1000000000ULL / clock + ((clock > 100000U) ? 1300U : 4700U);
+            hi2c->SimHsActive = 0;
+            hi2c->SimInFrame = 0;
+            hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+        }
+        hi2c->SimDmaFailed = 1;
+        hi2c->State = HAL_I2C_STATE_BUSY_TX;
+        hi2c->SimDmaPending = 1;
+        hi2c->SimBusyUntilNs = simNowNs + durationNs;
+        return HAL_OK;
+    }
+
+    CheckTiming(hi2c);
+    ack = hi2c->SimStuck ? -1 : SIM_DAC8571_Write(hi2c, (uint8_t)(DevAddress >> 1), pData, Size, simNowNs);
+    if (ack != 0) {
+        stop = 1; // a NACK aborts the sequence with a STOP
+    }
+
+    // (Repeated) START + 9 bits per byte, then STOP and bus free time only at the end of the sequence
+    uint64_t bits = 1 + 9 * (uint64_t)(((ack == 0) ? Size : 0) + 1);
+    uint64_t durationNs = bits * 1000000000ULL / clock;
+    if (stop) {
+        durationNs += 1000000000ULL / clock + ((clock > 100000U) ? 1300U : 4700U);
+        hi2c->SimInFrame = 0;
+        hi2c->SimHsActive = 0;
+        if (!hi2c->SimStuck) {
+            hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+        }
+    } else {
+        // Frame done, SCL held low: the HAL returns to READY and only a STOP through CR1 frees the bus
+        hi2c->SimInFrame = 1;
+        hi2c->SimFlags |= I2C_FLAG_BUSY;
+    }
+
+    hi2c->State = HAL_I2C_STATE_BUSY_TX;
+    hi2c->SimDmaFailed = (ack != 0);
+    hi2c->SimDmaPending = 1;
+    hi2c->SimBusyUntilNs = simNowNs + durationNs;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress) {
+    (void)DevAddress;
+    // Like the F4 HAL: only a master transfer still in progress can be aborted
+    if (!hi2c || !hi2c->SimDmaPending || hi2c->SimAbortPending) {
+        return HAL_ERROR;
+    }
+
+    // STOP after the byte in flight ends the held bus and high-speed mode
+    uint32_t clock = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+    hi2c->SimInFrame = 0;
+    hi2c->SimHsActive = 0;
+    if (!hi2c->SimStuck) {
+        hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+    }
+    hi2c->State = HAL_I2C_STATE_ABORT;
+    hi2c->SimAbortPending = 1;
+    hi2c->SimBusyUntilNs += 1000000000ULL / clock + 1300U;
+    return HAL_OK;
+}
+
+uint8_t SIM_I2C_GetFlag(I2C_HandleTypeDef *hi2c, uint32_t flag) {
+    if ((hi2c->SimRegs.CR1 & I2C_CR1_STOP) && !hi2c->SimDmaPending) {
+        // The peripheral clears the STOP bit once the condition is on the bus
+        hi2c->SimRegs.CR1 &= ~I2C_CR1_STOP;
+        if (hi2c->SimInFrame) {
+            uint32_t clock = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+            hi2c->SimInFrame = 0;
+            hi2c->SimHsActive = 0;
+            SIM_Advance(1000000000ULL / clock + ((clock > 100000U) ? 1300U : 4700U));
+        }
+        if (!hi2c->SimStuck) {
+            hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+        }
+    }
+    return (hi2c->SimFlags & flag) == flag;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c) {
+    if (!hi2c) {
+        return HAL_ERROR;
+    }
+    if (!hi2c->SimStuck) {
+        hi2c->SimFlags &= ~I2C_FLAG_BUSY;
+    }
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    hi2c->State = HAL_I2C_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c) {
+    if (!hi2c) {
+        return HAL_ERROR;
+    }
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c) {
+    return hi2c->State;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c) {
+    return hi2c->ErrorCode;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    if (!htim) {
+        return HAL_ERROR;
+    }
+    for (uint8_t i = 0; i < SIM_MAX_TIMERS; i++) {
+        if (simTimers[i] == NULL || simTimers[i] == htim) {
+            simTimers[i] = htim;
+            htim->SimRunning = 1;
+            htim->SimNextNs = simNowNs + TimerPeriodNs(htim);
+            return HAL_OK;
+        }
+    }
+    return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+    if (!htim) {
+        return HAL_ERROR;
+    }
+    htim->SimRunning = 0;
+    return HAL_OK;
+}
+
+void SIM_I2C_SetPins(I2C_HandleTypeDef *hi2c, GPIO_TypeDef *port, uint16_t sclPin, uint16_t sdaPin) {
+    TrackBus(hi2c);
+    hi2c->SimPort = port;
+    hi2c->SimSclPin = sclPin;
+    hi2c->SimSdaPin = sdaPin;
+    port->ODR |= (uint32_t)(sclPin | sdaPin); // pulled up
+}
+
+void *SIM_MutexNew(void) {
+    if (simMutexCount >= SIM_MAX_MUTEXES) {
+        return NULL;
+    }
+    return &simMutexes[simMutexCount++];
+}
+
+int SIM_MutexAcquire(void *mutex, uint32_t timeoutMs) {
+    (void)timeoutMs;
+    SIM_MutexTypeDef *m = (SIM_MutexTypeDef *)mutex;
+    if (m->held) {
+        m->contentions++;
+        return 0;
+    }
+    m->held = 1;
+    m->acquisitions++;
+    return 1;
+}
+
+void SIM_MutexRelease(void *mutex) {
+    SIM_MutexTypeDef *m = (SIM_MutexTypeDef *)mutex;
+    if (!m->held) {
+        m->errors++;
+    }
+    m->held = 0;
+}
+
+void SIM_MutexGetTotals(SIM_MutexTypeDef *total) {
+    SIM_MutexTypeDef sum = {0};
+    for (uint8_t i = 0; i < simMutexCount; i++) {
+        sum.held += simMutexes[i].held;
+        sum.acquisitions += simMutexes[i].acquisitions;
+        sum.contentions += simMutexes[i].contentions;
+        sum.errors += simMutexes[i].errors;
+    }
+    *total = sum;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+    if (GPIO_Init->Mode == GPIO_MODE_OUTPUT_OD) {
+        GPIOx->SimOpenDrain |= GPIO_Init->Pin;
+    } else {
+        GPIOx->SimOpenDrain &= ~GPIO_Init->Pin;
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    uint32_t previous = GPIOx->ODR;
+    if (PinState == GPIO_PIN_SET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+
+    // A rising SCL edge clocks one bit out of a slave that is holding SDA low
+    for (uint8_t i = 0; i < SIM_MAX_BUSES; i++) {
+        I2C_HandleTypeDef *hi2c = simBuses[i];
+        if (!hi2c || hi2c->SimPort != GPIOx || !(GPIO_Pin & hi2c->SimSclPin)) {
+            continue;
+        }
+        if (PinState == GPIO_PIN_SET && !(previous & hi2c->SimSclPin) &&
+            hi2c->SimStuck && hi2c->SimStuckClocks > 0 && --hi2c->SimStuckClocks == 0) {
+            hi2c->SimStuck = 0;
+        }
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    for (uint8_t i = 0; i < SIM_MAX_BUSES; i++) {
+        I2C_HandleTypeDef *hi2c = simBuses[i];
+        if (hi2c && hi2c->SimPort == GPIOx && (GPIO_Pin & hi2c->SimSdaPin) && hi2c->SimStuck) {
+            return GPIO_PIN_RESET;
+        }
+    }
+    return (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_Delay(uint32_t Delay) {
+    SIM_Advance((uint64_t)Delay * 1000000ULL);
+}
+
+uint32_t HAL_GetTick(void) {
+    // Polling loops must make progress: each call costs a little virtual CPU time
+    SIM_Advance(SIM_CPU_NS_PER_POLL);
+    return (uint32_t)(simNowNs / 1000000ULL);
+}
@@ -0,0 +1,431 @@
+/*
+ * @file    sim_main.c
+ * @author  lekhnitsky
+ * @brief   Host entry point: runs the DAC8571 self-test and benchmark on the simulated bus.
+ * @date    2025-01-17
+ */
+
+#include "dac8571.h"
+#include "dac8571_log.h"
+#include "dac8571_queue.h"
+#include "dac8571_coalesce.h"
+#include "dac8571_sched.h"
+#include "dac8571_ramp.h"
+#include "dac8571_wave.h"
+#include "dac8571_model.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef DAC8571_USE_HAL_I2C_CALLBACKS
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    DAC8571_I2C_MasterTxCpltHandler(hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    DAC8571_I2C_ErrorHandler(hi2c);
+}
+#endif
+
+static DAC8571_QueueTypeDef queue;
+static uint16_t queueRing[16];
+static TIM_HandleTypeDef htimControl;
+static TIM_HandleTypeDef htimSched;
+static TIM_HandleTypeDef htimRamp;
+static TIM_HandleTypeDef htimWave;
+static DAC8571_WaveTypeDef wave;
+static uint16_t controlCode;
+
+/* 10 kHz control loop: compute a setpoint and hand it to the writer without touching the bus */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    if (htim == &htimControl) {
+        controlCode += 97;
+        DAC8571_Queue_Push(&queue, controlCode);
+        DAC8571_Queue_ProcessAsync(&queue);
+    }
+    DAC8571_Sched_TimerHandler(htim);
+    DAC8571_Ramp_TimerHandler(htim);
+    DAC8571_Wave_TimerHandler(&wave, htim);
+}
+
+static void QueueTxCplt(DAC8571_HandleTypeDef *hdac8571) {
+    (void)hdac8571;
+    DAC8571_Queue_ProcessAsync(&queue);
+}
+
+/* Returns 1 if the DAC ends up holding the last setpoint of both runs */
+static uint8_t QueueDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    DAC8571_Queue_Init(&queue, hdac, queueRing, 16, DAC8571_QUEUE_LATEST_WINS);
+    DAC8571_RegisterCallbacks(hdac, QueueTxCplt, NULL);
+
+    htimControl.Init.Prescaler = 0;
+    htimControl.Init.Period = SIM_TIM_CLOCK_HZ / 10000U - 1;
+    controlCode = 0;
+    HAL_TIM_Base_Start_IT(&htimControl);
+    HAL_Delay(50);
+    HAL_TIM_Base_Stop_IT(&htimControl);
+    HAL_Delay(1);
+    uint8_t ok = (model->dacReg == controlCode);
+    printf("Queue (10 kHz ISR, DMA chain): last 0x%04X, DAC 0x%04X, high water %lu, %lu overflows\r\n",
+           controlCode, model->dacReg, (unsigned long)DAC8571_Queue_GetHighWater(&queue),
+           (unsigned long)DAC8571_Queue_GetOverflows(&queue));
+
+    // Writer stalled: 20 setpoints into 16 slots, the newest is kept and 3 are discarded
+    DAC8571_RegisterCallbacks(hdac, NULL, NULL);
+    for (uint16_t i = 1; i <= 20; i++) {
+        DAC8571_Queue_Push(&queue, (uint16_t)(i * 1000));
+    }
+    uint32_t queued = DAC8571_Queue_GetCount(&queue);
+    DAC8571_Queue_Process(&queue);
+    ok &= (model->dacReg == 20000 && DAC8571_Queue_GetCount(&queue) == 0);
+    printf("Queue (writer stalled, latest wins): %lu queued, %lu overflows, DAC 0x%04X\r\n",
+           (unsigned long)queued, (unsigned long)DAC8571_Queue_GetOverflows(&queue), model->dacReg);
+    return ok;
+}
+
+/* Returns 1 if only the newest setpoint per channel reaches the bus, higher priority first */
+static uint8_t CoalesceDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    DAC8571_HandleTypeDef hdac2 = {0};
+    SIM_DAC8571TypeDef *model2 = SIM_DAC8571_Attach(hdac->hi2c, 0x4E);
+    DAC8571_Init(&hdac2, hdac->hi2c, 0x4E);
+
+    DAC8571_CoalesceEntryTypeDef entries[2];
+    DAC8571_CoalesceTypeDef coalesce;
+    DAC8571_Coalesce_Init(&coalesce, entries, 2, DAC8571_COALESCE_PRIORITY);
+    DAC8571_Coalesce_Add(&coalesce, hdac, 0);
+    DAC8571_Coalesce_Add(&coalesce, &hdac2, 1);
+
+    // Ten table updates while the bus is not served: only the last one is written
+    uint16_t table[2];
+    for (uint16_t i = 1; i <= 10; i++) {
+        table[0] = (uint16_t)(i * 100);
+        table[1] = (uint16_t)(i * 200);
+        DAC8571_Coalesce_SubmitTable(&coalesce, table);
+    }
+    uint32_t updates = model->updates;
+    DAC8571_Coalesce_Process(&coalesce, 1);
+    uint8_t ok = (model2->dacReg == 2000 && model->updates == updates);
+    DAC8571_Coalesce_Process(&coalesce, 0);
+    ok &= (model->dacReg == 1000 && model->updates == updates + 1);
+
+    // Same table again: both devices already hold it
+    DAC8571_Coalesce_SubmitTable(&coalesce, table);
+    DAC8571_Coalesce_Process(&coalesce, 0);
+
+    DAC8571_CoalesceStatsTypeDef stats;
+    DAC8571_Coalesce_GetStats(&coalesce, &stats);
+    ok &= (stats.written == 2 && stats.dropped == 18 && stats.unchanged == 2);
+    printf("Coalesce: %lu submitted, %lu written, %lu stale dropped, %lu unchanged\r\n",
+           (unsigned long)stats.submitted, (unsigned long)stats.written,
+           (unsigned long)stats.dropped, (unsigned long)stats.unchanged);
+    return ok;
+}
+
+/* Returns 1 if scheduled writes latch in deadline order, the last one close to its requested time */
+static uint8_t SchedDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    // 10 us dispatch tick; start each write one 3-byte transfer (38 SCL periods) early
+    htimSched.Init.Prescaler = 0;
+    htimSched.Init.Period = SIM_TIM_CLOCK_HZ / 100000U - 1;
+    uint32_t leadUs = 38U * 1000000U / hdac->hi2c->Init.ClockSpeed;
+    DAC8571_Sched_ResetStats();
+    DAC8571_Sched_Start(&htimSched, leadUs);
+
+    // Submitted out of order; the two writes due last share a deadline and the later one wins
+    static const uint8_t order[8] = {5, 2, 7, 0, 3, 6, 1, 4};
+    uint32_t now = DAC8571_Sched_GetTimeUs();
+    for (uint8_t i = 0; i < 8; i++) {
+        DAC8571_ScheduleWrite(hdac, (uint16_t)(order[i] * 1000 + 1000), now + 1000 + order[i] * 500U);
+    }
+    uint32_t lastUs = now + 1000 + 8 * 500U;
+    DAC8571_ScheduleWrite(hdac, 0xAAAA, lastUs);
+    DAC8571_ScheduleWrite(hdac, 0xBBBB, lastUs);
+    HAL_Delay(10);
+    DAC8571_Sched_Stop();
+
+    DAC8571_SchedStatsTypeDef stats;
+    DAC8571_Sched_GetStats(&stats);
+    int32_t latchErrorUs = (int32_t)((uint32_t)(model->lastUpdateNs / 1000U) - lastUs);
+    printf("Sched: %lu dispatched, %lu deferred, dispatch latency min/mean/max %lu/%lu/%lu us, last write latched %+ld us from request\r\n",
+           (unsigned long)stats.dispatched, (unsigned long)stats.deferred, (unsigned long)stats.minDispatchLatencyUs,
+           (unsigned long)(stats.dispatched ? stats.totalDispatchLatencyUs / stats.dispatched : 0),
+           (unsigned long)stats.maxDispatchLatencyUs, (long)latchErrorUs);
+    uint8_t ok = (model->dacReg == 0xBBBB && stats.dispatched == 10 && stats.failed == 0 && DAC8571_Sched_GetPending() == 0);
+
+    // A long array transfer holds the first bus; the write due on a second, idle bus must not wait for it
+    static I2C_HandleTypeDef hi2c2;
+    static uint16_t burst[64];
+    hi2c2.Init.ClockSpeed = hdac->hi2c->Init.ClockSpeed;
+    hi2c2.State = HAL_I2C_STATE_READY;
+    SIM_DAC8571TypeDef *model2 = SIM_DAC8571_Find(&hi2c2, 0x4C);
+    if (!model2) {
+        model2 = SIM_DAC8571_Attach(&hi2c2, 0x4C);
+    }
+    DAC8571_HandleTypeDef hdac2 = {0};
+    DAC8571_Init(&hdac2, &hi2c2, 0x4C);
+    for (uint8_t i = 0; i < 64; i++) {
+        burst[i] = (uint16_t)(i * 1000);
+    }
+    DAC8571_Sched_ResetStats();
+    DAC8571_Sched_Start(&htimSched, leadUs);
+    now = DAC8571_Sched_GetTimeUs();
+    uint32_t dueUs = now + 200;
+    ok &= (DAC8571_WriteArrayAsync(hdac, burst, 64) == HAL_OK);
+    DAC8571_ScheduleWrite(hdac, 0x1111, dueUs);
+    DAC8571_ScheduleWrite(&hdac2, 0x2222, dueUs);
+    DAC8571_ScheduleWrite(&hdac2, 0x3333, dueUs + 100);
+    HAL_Delay(10);
+    DAC8571_Sched_Stop();
+
+    DAC8571_Sched_GetStats(&stats);
+    int32_t idleErrorUs = (int32_t)((uint32_t)(model2->lastUpdateNs / 1000U) - (dueUs + 100));
+    int32_t busyErrorUs = (int32_t)((uint32_t)(model->lastUpdateNs / 1000U) - dueUs);
+    printf("Sched: busy bus held %lu times, idle bus latched %+ld us, busy bus %+ld us from request\r\n",
+           (unsigned long)stats.deferred, (long)idleErrorUs, (long)busyErrorUs);
+    ok &= (model->dacReg == 0x1111 && model2->dacReg == 0x3333 && stats.dispatched == 3 && stats.failed == 0 &&
+           stats.deferred > 0 && idleErrorUs < 200 && busyErrorUs > 1000 && DAC8571_Sched_GetPending() == 0);
+    return ok;
+}
+
+static uint8_t rampsDone;
+static uint8_t rampsFailed;
+
+static void RampDone(DAC8571_RampTypeDef *ramp) {
+    (void)ramp;
+    rampsDone++;
+}
+
+static void RampError(DAC8571_RampTypeDef *ramp) {
+    (void)ramp;
+    rampsFailed++;
+}
+
+/* Returns 1 if two concurrent ramps send every code and end exactly on target */
+static uint8_t RampDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    DAC8571_HandleTypeDef hdac2 = {0};
+    SIM_DAC8571TypeDef *model2 = SIM_DAC8571_Find(hdac->hi2c, 0x4E);
+    DAC8571_Init(&hdac2, hdac->hi2c, 0x4E);
+    DAC8571_Write(&hdac2, 0x0000);
+
+    // 1 kHz tick, 8 codes per burst: 8 kSPS per ramp
+    htimRamp.Init.Prescaler = 0;
+    htimRamp.Init.Period = SIM_TIM_CLOCK_HZ / 1000U - 1;
+    DAC8571_Ramp_EngineStart(&htimRamp, 1000, 8);
+
+    DAC8571_RampTypeDef rampA = {0};
+    DAC8571_RampTypeDef rampB = {0};
+    rampA.DoneCallback = RampDone;
+    rampB.DoneCallback = RampDone;
+    rampsDone = 0;
+    uint32_t updatesA = model->updates;
+    uint32_t updatesB = model2->updates;
+    DAC8571_Ramp_ToCode(&rampA, hdac, 0xFFFF, 100);
+    DAC8571_Ramp_Slew(&rampB, &hdac2, 1.0f, 100.0f);
+    uint8_t ok = (DAC8571_Ramp_ToCode(&rampB, hdac, 0, 1) == HAL_BUSY);
+    HAL_Delay(30);
+
+    updatesA = model->updates - updatesA;
+    updatesB = model2->updates - updatesB;
+    ok &= (rampsDone == 2 && model->dacReg == 0xFFFF && model2->dacReg == rampB.target &&
+           updatesA == rampA.samples && updatesB == rampB.samples);
+    printf("Ramp: %u done, %lu + %lu codes at 8 kSPS, DAC 0x%04X / 0x%04X, %lu missed ticks\r\n",
+           rampsDone, (unsigned long)updatesA, (unsigned long)updatesB, model->dacReg, model2->dacReg,
+           (unsigned long)(rampA.missedTicks + rampB.missedTicks));
+
+    // A burst that times out mid-ramp stops the ramp without reporting it done
+    rampA.ErrorCallback = RampError;
+    rampsFailed = 0;
+    DAC8571_Ramp_ToCode(&rampA, hdac, 0, 100);
+    HAL_Delay(3);
+    hdac->hi2c->SimStuck = 1;
+    HAL_Delay(3);
+    hdac->hi2c->SimStuck = 0;
+    DAC8571_Ramp_EngineStop();
+    ok &= (DAC8571_Ramp_GetState(&rampA) == DAC8571_RAMP_FAILED && rampsFailed == 1 && rampsDone == 2 &&
+           model->dacReg == hdac->lastValue && model->dacReg != 0);
+    printf("Ramp (bus stuck mid-ramp): %s, DAC holds 0x%04X\r\n",
+           (DAC8571_Ramp_GetState(&rampA) == DAC8571_RAMP_FAILED) ? "failed" : "NOT failed", model->dacReg);
+    return ok;
+}
+
+#define WAVE_HALF 8
+
+static uint16_t waveRing[2 * WAVE_HALF];
+static uint16_t waveNext;
+static uint8_t waveRefills;
+
+/* Each sample is its own index in the stream, so the DAC value tells how many were played */
+static void WaveFill(uint16_t *half) {
+    for (uint16_t i = 0; i < WAVE_HALF; i++) {
+        half[i] = waveNext++;
+    }
+}
+
+static void WaveHalfCplt(DAC8571_WaveTypeDef *player, uint16_t *half) {
+    if (waveRefills > 0) {
+        waveRefills--;
+        WaveFill(half);
+        DAC8571_Wave_HalfReady(player, half);
+    }
+}
+
+/* Returns 1 if the player streams every refilled sample in order, holds on underrun and stops cleanly */
+static uint8_t WaveDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    // 5 kHz sample rate; the application keeps up for four halves, then falls behind
+    htimWave.Init.Prescaler = 0;
+    htimWave.Init.Period = SIM_TIM_CLOCK_HZ / 5000U - 1;
+    uint8_t ok = (DAC8571_Wave_Init(&wave, hdac, &htimWave, waveRing, DAC8571_WAVE_MAX_HALF_LENGTH + 1) == HAL_ERROR);
+    ok &= (DAC8571_Wave_Init(&wave, hdac, &htimWave, waveRing, WAVE_HALF) == HAL_OK);
+    wave.HalfCpltCallback = WaveHalfCplt;
+    waveNext = 0;
+    WaveFill(waveRing);
+    WaveFill(waveRing + WAVE_HALF);
+    waveRefills = 4;
+    uint32_t updates = model->updates;
+
+    ok &= (DAC8571_Wave_Start(&wave) == HAL_OK);
+    HAL_Delay(15);
+    uint32_t beforeUnderrun = wave.samplesPlayed;
+    ok &= (DAC8571_Wave_GetState(&wave) == DAC8571_WAVE_UNDERRUN && DAC8571_Wave_GetUnderruns(&wave) == 1 &&
+           beforeUnderrun == 6 * WAVE_HALF && model->dacReg == beforeUnderrun - 1);
+
+    // Catch up: hand both halves back and keep refilling
+    waveRefills = 0xFF;
+    WaveFill(waveRing);
+    WaveFill(waveRing + WAVE_HALF);
+    DAC8571_Wave_HalfReady(&wave, waveRing);
+    DAC8571_Wave_HalfReady(&wave, waveRing + WAVE_HALF);
+    HAL_Delay(4);
+    ok &= (DAC8571_Wave_GetState(&wave) == DAC8571_WAVE_RUNNING && wave.samplesPlayed > beforeUnderrun);
+
+    DAC8571_Wave_Stop(&wave);
+    HAL_Delay(2);
+    uint32_t played = wave.samplesPlayed;
+    updates = model->updates - updates;
+    ok &= (DAC8571_Wave_GetState(&wave) == DAC8571_WAVE_STOPPED && updates == played &&
+           model->dacReg == played - 1 && DAC8571_Wave_GetUnderruns(&wave) == 1 && wave.missedTicks == 0);
+    printf("Wave: %lu samples at 5 kHz, %lu underrun after %lu, DAC 0x%04X after stop, %lu missed ticks\r\n",
+           (unsigned long)played, (unsigned long)DAC8571_Wave_GetUnderruns(&wave), (unsigned long)beforeUnderrun,
+           model->dacReg, (unsigned long)wave.missedTicks);
+    return ok;
+}
+
+static uint32_t recoveriesInIsr;
+static uint8_t pendingInIsr;
+
+static void RecoveryError(DAC8571_HandleTypeDef *hdac8571) {
+    recoveriesInIsr = hdac8571->busRecoveries;
+    pendingInIsr = hdac8571->recoveryPending;
+}
+
+/* Returns 1 if a DMA timeout only flags the bus and the next blocking write recovers it */
+static uint8_t RecoveryDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    static GPIO_TypeDef gpio;
+    SIM_I2C_SetPins(hdac->hi2c, &gpio, 0x0040, 0x0080);
+    DAC8571_SetRecoveryPins(hdac, &gpio, 0x0040, &gpio, 0x0080);
+    DAC8571_RegisterCallbacks(hdac, NULL, RecoveryError);
+
+    uint32_t recoveries = hdac->busRecoveries;
+    pendingInIsr = 0;
+    hdac->hi2c->SimStuck = 1;
+    hdac->hi2c->SimStuckClocks = 3;
+    uint8_t ok = (DAC8571_WriteAsync(hdac, 0x1234) == HAL_OK);
+    HAL_Delay(1);
+    ok &= (recoveriesInIsr == recoveries && pendingInIsr && hdac->busRecoveries == recoveries);
+
+    ok &= (DAC8571_Write(hdac, 0x4321) == HAL_OK);
+    ok &= (hdac->busRecoveries == recoveries + 1 && !hdac->recoveryPending && model->dacReg == 0x4321);
+    printf("Recovery: DMA timeout deferred %s, %lu recovery before the next write, DAC 0x%04X\r\n",
+           pendingInIsr ? "from the interrupt" : "NOT", (unsigned long)(hdac->busRecoveries - recoveries), model->dacReg);
+
+    DAC8571_RegisterCallbacks(hdac, NULL, NULL);
+    DAC8571_SetRecoveryPins(hdac, NULL, 0, NULL, 0);
+    return ok;
+}
+
+/* Returns 1 if HS mode is refused on an F4-like HAL and streams cleanly on an HS-capable port */
+static uint8_t HsDemo(DAC8571_HandleTypeDef *hdac, SIM_DAC8571TypeDef *model) {
+    I2C_HandleTypeDef *hi2c = hdac->hi2c;
+    uint32_t clockHz = hi2c->Init.ClockSpeed;
+    uint32_t violations = hi2c->SimTimingViolations;
+
+    // F4 HAL: the STOP after the master-code NACK leaves the bus in F/S mode
+    uint8_t ok = (DAC8571_HS_Begin(hdac, DAC8571_HS_MAX_CLOCK_HZ) == HAL_ERROR && !hdac->hsActive && !hi2c->SimInFrame);
+
+    // HS-capable port: bursts at 3.4 MHz joined by repeated STARTs, one STOP at the end
+    static uint16_t ramp[256];
+    for (uint16_t i = 0; i < 256; i++) {
+        ramp[i] = (uint16_t)(i * 257);
+    }
+    hi2c->SimHsCapable = 1;
+    uint64_t startNs = SIM_GetTimeNs();
+    ok &= (DAC8571_HS_Begin(hdac, DAC8571_HS_MAX_CLOCK_HZ) == HAL_OK);
+    ok &= (DAC8571_WriteStream(hdac, ramp, 256) == HAL_OK);
+    ok &= (DAC8571_HS_End(hdac) == HAL_OK);
+    uint64_t elapsedNs = SIM_GetTimeNs() - startNs;
+    hi2c->SimHsCapable = 0;
+
+    ok &= (!hi2c->SimInFrame && hi2c->Init.ClockSpeed == clockHz && hi2c->SimTimingViolations == violations &&
+           model->dacReg == ramp[255]);
+    printf("HS: refused on the F4 HAL (STOP after the master code); HS-capable port streams 256 samples in %lu us, %lu timing violations\r\n",
+           (unsigned long)(elapsedNs / 1000U), (unsigned long)(hi2c->SimTimingViolations - violations));
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    uint32_t clockHz = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 400000U;
+    uint32_t samples = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 4000U;
+
+    I2C_HandleTypeDef hi2c1 = {0};
+    hi2c1.Init.ClockSpeed = clockHz;
+    hi2c1.State = HAL_I2C_STATE_READY;
+
+    SIM_Reset();
+    SIM_DAC8571TypeDef *model = SIM_DAC8571_Attach(&hi2c1, 0x4C);
+
+    DAC8571_HandleTypeDef hdac = {0};
+    DAC8571_Init(&hdac, &hi2c1, 0x4C);
+
+    DAC8571_SelfTest(&hdac);
+
+    DAC8571_SetWriteMode(&hdac, DAC8571_CMD_WRITE_AND_UPDATE_DAC);
+    printf("\r\nSimulated SCL: %lu Hz\r\n", (unsigned long)clockHz);
+    DAC8571_Benchmark(&hdac, samples);
+    uint8_t queueOk = QueueDemo(&hdac, model);
+    uint8_t coalesceOk = CoalesceDemo(&hdac, model);
+    uint8_t schedOk = SchedDemo(&hdac, model);
+    uint8_t rampOk = RampDemo(&hdac, model);
+    uint8_t waveOk = WaveDemo(&hdac, model);
+    uint8_t recoveryOk = RecoveryDemo(&hdac, model);
+    uint8_t hsOk = HsDemo(&hdac, model);
+
+#ifdef DAC8571_ENABLE_STATS
+    DAC8571_StatsTypeDef stats;
+    DAC8571_GetStats(&hdac, &stats);
+    printf("Stats: %lu transactions, %lu errors, %lu bytes, latency min/mean/max %lu/%lu/%lu ns, init %lu ns\r\n",
+           (unsigned long)stats.transactions, (unsigned long)stats.errors, (unsigned long)stats.bytes,
+           (unsigned long)stats.minCycles, (unsigned long)stats.meanCycles, (unsigned long)stats.maxCycles,
+           (unsigned long)stats.initCycles);
+#endif
+
+#if DAC8571_LOG_LEVEL > DAC8571_LOG_LEVEL_NONE
+    printf("Deferred log (%lu dropped):\r\n", (unsigned long)DAC8571_Log_GetDropped());
+    DAC8571_Log_Process();
+#endif
+
+    uint8_t mutexOk = 1;
+#ifdef DAC8571_BUS_LOCK
+    // Every task-side lock went through the mutex and was given back exactly once
+    SIM_MutexTypeDef mutexes;
+    SIM_MutexGetTotals(&mutexes);
+    mutexOk = (mutexes.acquisitions > 0 && mutexes.held == 0 && mutexes.errors == 0);
+    printf("Bus mutex: %lu acquisitions, %lu contended, %u still held, %lu bad releases\r\n",
+           (unsigned long)mutexes.acquisitions, (unsigned long)mutexes.contentions, mutexes.held,
+           (unsigned long)mutexes.errors);
+#endif
+
+    printf("Model: %lu transactions, %lu bytes, %lu updates, virtual time %.3f ms\r\n",
+           (unsigned long)model->transactions, (unsigned long)model->bytes,
+           (unsigned long)model->updates, (double)SIM_GetTimeNs() / 1e6);
+    printf("Bus: %lu timing violations, SCL %lu Hz after benchmark\r\n",
+           (unsigned long)hi2c1.SimTimingViolations, (unsigned long)hi2c1.Init.ClockSpeed);
+    return (hi2c1.SimTimingViolations == 0 && queueOk && coalesceOk && schedOk && rampOk && waveOk && recoveryOk && hsOk && mutexOk) ? 0 : 1;
+}
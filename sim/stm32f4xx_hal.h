@@ -0,0 +1,275 @@
+/*
+ * @file    stm32f4xx_hal.h
+ * @author  lekhnitsky
+ * @brief   Host stand-in for the STM32F4 HAL surface used by the DAC8571 library.
+ *          Transfers are served by a behavioral DAC8571 model on a virtual bus clock.
+ * @date    2025-01-17
+ */
+
+#ifndef SIM_STM32F4XX_HAL_H_
+#define SIM_STM32F4XX_HAL_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HAL_SIM 1 ///< Building against the host simulator
+
+/**
+ * @brief HAL status structure.
+ */
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY      0xFFFFFFFFU
+
+/**
+ * @brief I2C state structure.
+ */
+typedef enum {
+    HAL_I2C_STATE_RESET   = 0x00U,
+    HAL_I2C_STATE_READY   = 0x20U,
+    HAL_I2C_STATE_BUSY    = 0x24U,
+    HAL_I2C_STATE_BUSY_TX = 0x21U,
+    HAL_I2C_STATE_BUSY_RX = 0x22U,
+    HAL_I2C_STATE_ABORT   = 0x60U,
+    HAL_I2C_STATE_ERROR   = 0xE0U
+} HAL_I2C_StateTypeDef;
+
+#define HAL_I2C_ERROR_NONE      0x00000000U ///< No error
+#define HAL_I2C_ERROR_BERR      0x00000001U ///< Bus error
+#define HAL_I2C_ERROR_AF        0x00000004U ///< Acknowledge failure
+#define HAL_I2C_ERROR_TIMEOUT   0x00000020U ///< Timeout error
+
+#define I2C_FLAG_BUSY           0x00100002U ///< Bus busy flag
+#define I2C_CR1_STOP            0x00000200U ///< Generate a STOP after the current byte
+
+#define SET_BIT(REG, BIT)       ((REG) |= (BIT))
+
+/* Outcome of a failing simulated DMA transfer (I2C_HandleTypeDef::SimDmaFailed) */
+#define SIM_DMA_NACK            1U ///< Address or data NACK: error interrupt with HAL_I2C_ERROR_AF
+#define SIM_DMA_TIMEOUT         2U ///< Bus held low: error interrupt with HAL_I2C_ERROR_TIMEOUT
+
+/* Sequential transfer options (HAL_I2C_Master_Seq_Transmit_IT) */
+#define I2C_FIRST_FRAME             0x00000001U ///< START, no STOP
+#define I2C_FIRST_AND_NEXT_FRAME    0x00000002U
+#define I2C_NEXT_FRAME              0x00000004U ///< Repeated START, no STOP
+#define I2C_FIRST_AND_LAST_FRAME    0x00000008U ///< START and STOP
+#define I2C_LAST_FRAME_NO_STOP      0x00000010U
+#define I2C_LAST_FRAME              0x00000020U ///< Repeated START, then STOP
+#define I2C_OTHER_FRAME             0x00AA0000U
+#define I2C_OTHER_AND_LAST_FRAME    0xAA000000U
+
+/**
+ * @brief GPIO port and configuration structures (subset).
+ */
+typedef struct {
+    uint32_t ODR;             ///< Output data register
+    uint32_t SimOpenDrain;    ///< Pins configured as open-drain outputs
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_MODE_INPUT          0x00000000U
+#define GPIO_MODE_OUTPUT_OD      0x00000011U
+#define GPIO_MODE_AF_OD          0x00000012U
+#define GPIO_NOPULL              0x00000000U
+#define GPIO_SPEED_FREQ_HIGH     0x00000002U
+
+/**
+ * @brief I2C peripheral registers (subset).
+ */
+typedef struct {
+    volatile uint32_t CR1;
+} I2C_TypeDef;
+
+/**
+ * @brief I2C configuration structure (subset).
+ */
+typedef struct {
+    uint32_t ClockSpeed;     ///< SCL frequency in Hz (0 selects 100 kHz)
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+} I2C_InitTypeDef;
+
+/**
+ * @brief I2C handle structure (subset plus simulator state).
+ */
+typedef struct __I2C_HandleTypeDef {
+    I2C_TypeDef *Instance;    ///< Points at SimRegs once the bus has been used
+    I2C_InitTypeDef Init;
+    volatile HAL_I2C_StateTypeDef State;
+    volatile uint32_t ErrorCode;
+
+    I2C_TypeDef SimRegs;      ///< Simulated peripheral registers
+    uint32_t SimFlags;        ///< Simulated status flags (I2C_FLAG_*)
+    uint64_t SimBusyUntilNs;  ///< End of the transfer currently on the bus
+    uint8_t SimDmaPending;    ///< A DMA transfer completes at SimBusyUntilNs
+    uint8_t SimDmaFailed;     ///< The pending DMA transfer fails (SIM_DMA_NACK or SIM_DMA_TIMEOUT)
+    uint8_t SimAbortPending;  ///< The pending transfer was stopped by HAL_I2C_Master_Abort_IT
+    uint8_t SimInFrame;       ///< Sequential transfer holds the bus (no STOP yet)
+    uint8_t SimHsActive;      ///< High-speed mode entered by a master code, until STOP
+    uint8_t SimHsCapable;     ///< Port keeps the bus after the NACKed master code (0: STOP, as the F4 HAL)
+    uint32_t SimTimingViolations; ///< Frames clocked faster than the bus mode allows
+    uint8_t SimStuck;         ///< Fault injection: bus held low, every transfer times out
+    uint8_t SimStuckClocks;   ///< SCL pulses after which a stuck slave releases SDA (0: never)
+    GPIO_TypeDef *SimPort;    ///< GPIO port wired to SCL/SDA (see SIM_I2C_SetPins)
+    uint16_t SimSclPin;       ///< SCL pin mask on SimPort
+    uint16_t SimSdaPin;       ///< SDA pin mask on SimPort
+} I2C_HandleTypeDef;
+
+#define __HAL_I2C_GET_FLAG(__HANDLE__, __FLAG__)   SIM_I2C_GetFlag((__HANDLE__), (__FLAG__))
+#define __HAL_I2C_CLEAR_FLAG(__HANDLE__, __FLAG__) ((__HANDLE__)->SimFlags &= ~(__FLAG__))
+
+/**
+ * @brief Timer configuration and handle structures (subset).
+ */
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct __TIM_HandleTypeDef {
+    void *Instance;
+    TIM_Base_InitTypeDef Init;
+    uint8_t SimRunning;       ///< Update interrupt enabled
+    uint64_t SimNextNs;       ///< Time of the next update event
+} TIM_HandleTypeDef;
+
+#define SIM_TIM_CLOCK_HZ    84000000U ///< Simulated timer kernel clock
+#define SIM_I2C_FM_MAX_HZ   400000U   ///< Fastest SCL without high-speed mode
+#define SIM_I2C_HS_MAX_HZ   3400000U  ///< Fastest SCL in high-speed mode
+#define SIM_I2C_MASTER_CODE 0x08U     ///< High-speed master codes are 00001xxx
+
+/**
+ * @brief Status flag read; a STOP requested through CR1 goes out first (it ends a held sequence).
+ * @param hi2c Pointer to the I2C handle.
+ * @param flag Flag to test (I2C_FLAG_*).
+ * @return 1 if the flag is set.
+ */
+uint8_t SIM_I2C_GetFlag(I2C_HandleTypeDef *hi2c, uint32_t flag);
+
+/* HAL API subset */
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t XferOptions);
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress);
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c);
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+void HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+
+/* Simulator controls */
+
+/**
+ * @brief Current virtual time in nanoseconds.
+ */
+uint64_t SIM_GetTimeNs(void);
+
+/**
+ * @brief Advance virtual time, firing timer updates and DMA completions on the way.
+ * @param ns Time to advance in nanoseconds.
+ */
+void SIM_Advance(uint64_t ns);
+
+/**
+ * @brief Bus time of one transaction (START, address, payload, STOP, bus free time).
+ * @param hi2c Pointer to the I2C handle (its Init.ClockSpeed sets the SCL rate).
+ * @param size Payload bytes after the address byte.
+ * @return Duration in nanoseconds.
+ */
+uint64_t SIM_TransactionTimeNs(I2C_HandleTypeDef *hi2c, uint16_t size);
+
+/**
+ * @brief Wire a bus to GPIO pins so bit-banged bus recovery reaches the stuck-slave model.
+ * @param hi2c Pointer to the I2C handle.
+ * @param port GPIO port carrying SCL and SDA.
+ * @param sclPin SCL pin mask.
+ * @param sdaPin SDA pin mask.
+ */
+void SIM_I2C_SetPins(I2C_HandleTypeDef *hi2c, GPIO_TypeDef *port, uint16_t sclPin, uint16_t sdaPin);
+
+/**
+ * @brief Counting stand-in for an RTOS mutex (see sim/dac8571_rtos_config.h).
+ * @details The simulator has a single thread, so a taken mutex is never waited for: the attempt
+ *          is counted as contended and fails.
+ */
+typedef struct {
+    uint8_t held;             ///< Currently taken
+    uint32_t acquisitions;    ///< Successful takes
+    uint32_t contentions;     ///< Takes that found the mutex held
+    uint32_t errors;          ///< Releases of a mutex that was not held
+} SIM_MutexTypeDef;
+
+/**
+ * @brief Create a mutex.
+ * @return Mutex handle, or NULL when all SIM_MAX_MUTEXES are in use.
+ */
+void *SIM_MutexNew(void);
+
+/**
+ * @brief Take a mutex.
+ * @param mutex Handle from SIM_MutexNew.
+ * @param timeoutMs Ignored: a held mutex fails at once.
+ * @return 1 if taken, 0 otherwise.
+ */
+int SIM_MutexAcquire(void *mutex, uint32_t timeoutMs);
+
+/**
+ * @brief Give a mutex back.
+ * @param mutex Handle from SIM_MutexNew.
+ */
+void SIM_MutexRelease(void *mutex);
+
+/**
+ * @brief Sum the counters of every mutex created.
+ * @param total Destination; held counts the mutexes still taken.
+ */
+void SIM_MutexGetTotals(SIM_MutexTypeDef *total);
+
+/**
+ * @brief Reset virtual time, buses and attached device models.
+ */
+void SIM_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* SIM_STM32F4XX_HAL_H_ */